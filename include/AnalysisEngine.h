@@ -0,0 +1,70 @@
+#pragma once
+
+#include "AudioSource.h"
+#include "AnalysisPipeline.h"
+#include "WorkStealingPool.h"
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Runs any number of independent analysis pipelines on one shared work-stealing
+// pool instead of a thread per stream. Each stream is a chain of tasks, a task
+// analyses a few packets of its source and resubmits itself, so a stream is never
+// processed by two threads at once while idle threads steal whole streams from
+// busy ones. Sources are polled without blocking, a stream with no packet ready
+// is parked and rescheduled a millisecond later.
+class AnalysisEngine
+{
+public:
+    // 0 threads means one per hardware thread
+    explicit AnalysisEngine(size_t numThreads = 0);
+    ~AnalysisEngine();
+
+    // Adds a stream while the engine is stopped and returns its index. The source
+    // must be initialized, it is started and stopped by its owner.
+    size_t addStream(AudioSource &source, unsigned int numFrequencyWindows, const AnalysisSettings &settings = AnalysisSettings());
+
+    size_t getStreamCount() const;
+    size_t getThreadCount() const;
+
+    void start();
+    void stop();
+
+    // True once every source has ended and its last packet has been analysed
+    bool isFinished() const;
+    void waitUntilFinished();
+
+    // Lock-free copy of a stream's latest frame, see AudioProcessor::readSpectrum
+    bool readSpectrum(size_t stream, SpectrumFrame &frame) const;
+    const AnalysisPipeline &getPipeline(size_t stream) const;
+
+private:
+    struct Stream
+    {
+        Stream(AudioSource &source, unsigned int numFrequencyWindows, const AnalysisSettings &settings);
+
+        AudioSource &source;
+        AnalysisPipeline pipeline;
+        bool finished;
+    };
+
+    void schedule(size_t stream);
+    void runStream(size_t stream);
+    void pollParkedStreams();
+
+    WorkStealingPool pool;
+    std::vector<std::unique_ptr<Stream>> streams;
+    std::atomic<bool> running;
+    std::atomic<size_t> activeStreams;
+
+    std::mutex parkedMutex;
+    std::condition_variable pollCondition;
+    std::vector<size_t> parkedStreams;
+    std::thread pollThread;
+
+    std::mutex finishedMutex;
+    std::condition_variable finishedCondition;
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "FFT.h"
+#include "STFTBuffer.h"
+#include "BandLayout.h"
+#include "ConstantQ.h"
+#include "WindowFunction.h"
+#include "ChannelMixer.h"
+#include "SlidingDFT.h"
+#include "LatencyTracer.h"
+#include "SpectrumPublisher.h"
+#include "PolyphaseResampler.h"
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <string>
+#include <complex>
+
+enum class AnalysisMode
+{
+    FFT,       // One FFT per frame averaged into frequency windows
+    ConstantQ,  // Multirate constant-Q bins, one per frequency window
+    SlidingDFT, // Per-sample sliding DFT resonators, one per frequency window
+    Auto,       // FFT or SlidingDFT, whichever measures cheaper for the band count
+};
+
+// Parses "fft", "constantq", "slidingdft" or "auto", anything else maps to FFT
+AnalysisMode parseAnalysisMode(const std::string &name);
+
+struct AnalysisSettings
+{
+    // Frames of windowSize samples are analysed every hopSize samples of the stream
+    size_t windowSize = 2048;
+    size_t hopSize = 512;
+    WindowType windowType = WindowType::Hann;
+    FrequencyScale frequencyScale = FrequencyScale::Log;
+    AnalysisMode mode = AnalysisMode::FFT;
+    ChannelMode channelMode = ChannelMode::Downmix;
+    // Rate the stream is resampled to before analysis so window and hop sizes mean
+    // the same on every device, 0 analyses at the source rate
+    unsigned int analysisSampleRate = 0;
+};
+
+// Analysis of one interleaved sample stream, from packets to published band
+// values. Not thread safe: packets must come from one thread at a time, the
+// published spectrum can be read from any thread.
+class AnalysisPipeline
+{
+public:
+    AnalysisPipeline(unsigned int numFrequencyWindows, double sampleRate, unsigned int numChannels, const AnalysisSettings &settings = AnalysisSettings());
+
+    // Picks the engine when the mode is Auto and sets up the per-stream state,
+    // runs on the first packet when it was not called before
+    void prepare();
+
+    // Analyses one packet of interleaved samples and publishes every frame it
+    // completes, true if at least one was published
+    bool processPacket(const float *interleaved, size_t numSamples, LatencyTracer::Clock::time_point captureTime, LatencyTracer::Clock::time_point acquireTime);
+
+    // numFrequencyWindows values per analysed stream, streams back to back
+    // (one for Downmix, one per channel for PerChannel, mid then side for MidSide)
+    bool readSpectrum(SpectrumFrame &frame) const;
+    unsigned long long getSequence() const;
+
+    unsigned int getNumFrequencyWindows() const;
+    // Rate the analysis runs at, the analysis rate of the settings when one is set
+    double getSampleRate() const;
+    // Frequency range the windows are spread over, in Hz
+    double getLowerFrequency() const;
+    double getUpperFrequency() const;
+    // Engine in use, differs from the configured mode when it is Auto and the pipeline is prepared
+    AnalysisMode getActiveMode() const;
+
+    // Steps of the FFT engine on their own, for benchmarks. The frame must hold
+    // windowSize samples, the output gets numFrequencyWindows values.
+    void calculateFrequencyWindowMagnitudes(const std::vector<float> &audioData, std::vector<float> &output);
+    void modifyLogAlternation(std::vector<float> &vec);
+
+private:
+    // Analysis state of one planar stream: a channel, mid, side or the downmix
+    struct ChannelAnalysis
+    {
+        ChannelAnalysis(size_t windowSize, size_t hopSize);
+
+        STFTBuffer stftBuffer;
+        std::unique_ptr<ConstantQ> constantQ;
+        std::unique_ptr<SlidingDFT> slidingDFT;
+        std::vector<float> samples;
+        std::vector<float> bands;
+    };
+
+    bool analyseFrames();
+    void readSlidingDFT();
+    void publishFrame(LatencyTracer::Clock::time_point captureTime, LatencyTracer::Clock::time_point acquireTime);
+    AnalysisMode chooseCheaperEngine();
+
+    unsigned int numFrequencyWindows;
+    double sampleRate;
+    size_t numChannels;
+    AnalysisSettings settings;
+    std::atomic<AnalysisMode> activeMode;
+    bool prepared;
+
+    std::unique_ptr<PolyphaseResampler> resampler;
+    std::vector<float> resampled;
+    std::vector<ChannelAnalysis> channels;
+    std::vector<float *> planarChannels;
+    WindowFunction window;
+    std::vector<float> frame;
+    FFTPlan fftPlan;
+    std::vector<std::complex<float>> fftOutput;
+    std::vector<float> magnitudes;
+    BandLayout bandLayout;
+    // Staging buffer of the values about to be published
+    std::vector<float> frequencyWindowMagnitudes;
+    SpectrumPublisher spectrumPublisher;
+};
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "AudioSource.h"
+#include "SPSCRingBuffer.h"
+#include "SampleFormat.h"
 #include <Windows.h>
 #include <mmdeviceapi.h>
 #include <Audioclient.h>
@@ -7,21 +10,29 @@
 #include <mutex>
 #include <condition_variable>
 #include <thread>
+#include <atomic>
+#include <memory>
 
-class AudioCapture
+class AudioCapture : public AudioSource
 {
 public:
     AudioCapture();
     ~AudioCapture();
 
-    bool initialize();
-    void startCapture();
-    void stopCapture();
+    bool initialize() override;
+    void startCapture() override;
+    void stopCapture() override;
     size_t getBufferSize() const;
-    float getSampleRate() const;
-    std::vector<float> getOutputBuffer();
-    bool hasNewData() const;
-    void waitUntilNewDataAvailable();
+    float getSampleRate() const override;
+    unsigned int getChannelCount() const override;
+    // Returns the captured samples in place in the ring, they are released on the
+    // next call. False once capture has stopped and everything has been read.
+    bool acquireBuffer(const float *&samples, size_t &numSamples, std::chrono::steady_clock::time_point &captureTime) override;
+    AcquireResult tryAcquireBuffer(const float *&samples, size_t &numSamples, std::chrono::steady_clock::time_point &captureTime) override;
+
+    // Packets the consumer fell too far behind for, and the samples they held
+    unsigned long long getOverrunCount() const;
+    unsigned long long getDroppedSampleCount() const;
 
 private:
     static DWORD WINAPI captureThread(LPVOID lpParameter);
@@ -39,14 +50,18 @@ private:
     IAudioCaptureClient *pCaptureClient;
 
     WAVEFORMATEX *pwfx;
+    // Encoding of the mix format, anything but float is converted before the ring
+    SampleFormat sampleFormat;
+    std::vector<float> convertedPacket;
     HANDLE captureThreadHandle;
     DWORD captureThreadId;
-    bool isCapturing;
+    std::atomic<bool> isCapturing;
     std::vector<float> audioData;
     std::mutex audioDataMutex;
     size_t bufferSize;
-    std::mutex outputBufferMutex;
-    std::vector<float> outputBuffer;
-    bool newData;
-    std::condition_variable newDataAvailable;
+    // Holds one second of interleaved samples between the capture and processing threads
+    std::unique_ptr<SPSCRingBuffer> ringBuffer;
+    size_t acquiredSamples;
+    // steady_clock ticks of the newest packet, stored before the packet is published
+    std::atomic<long long> latestPacketTime;
 };
\ No newline at end of file
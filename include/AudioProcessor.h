@@ -1,37 +1,69 @@
 #pragma once
 
-#include "AudioCapture.h"
+#include "AudioSource.h"
+#include "AnalysisPipeline.h"
+#include "SpectrumSink.h"
 #include <vector>
 #include <mutex>
-#include <windows.h>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
 
+// Runs one AnalysisPipeline on its own thread, fed from one AudioSource
 class AudioProcessor
 {
 public:
-    AudioProcessor(unsigned int numFrequencyWindows, AudioCapture &audioCapture);
+    AudioProcessor(unsigned int numFrequencyWindows, AudioSource &audioSource, const AnalysisSettings &settings = AnalysisSettings());
     ~AudioProcessor();
 
     void startProcessing();
     void stopProcessing();
+    // numFrequencyWindows values per analysed stream, streams back to back
+    // (one for Downmix, one per channel for PerChannel, mid then side for MidSide)
     std::vector<float> getFrequencyWindowMagnitudes();
+    // Same values with their capture and publish times
+    SpectrumFrame getSpectrumFrame();
     bool isReady() const;
     void waitUntilReady();
 
+    // Copies the latest published frame into frame without locking and, once its
+    // vector has grown to size, without allocating. False before the first frame.
+    // Safe to call from any number of threads.
+    bool readSpectrum(SpectrumFrame &frame) const;
+    // Blocks until a frame newer than sequence is published or processing has finished
+    void waitForSpectrumAfter(unsigned long long sequence);
+
+    // Pushes every frame published from now on to sink, on the processing thread,
+    // with no thread in between to wake. Once unsubscribe returns the sink is not
+    // called again and can be destroyed.
+    void subscribe(SpectrumSink &sink);
+    void unsubscribe(SpectrumSink &sink);
+
+    // True once the source has ended and its last packet has been analysed
+    bool isFinished() const;
+    void waitUntilFinished();
+
+    // Engine in use, differs from the configured mode when it is Auto and processing has started
+    AnalysisMode getActiveMode() const;
+
 private:
-    static DWORD WINAPI processingThreadEntryPoint(LPVOID lpParameter);
     void processAudio();
-    std::vector<float> calculateFrequencyWindowMagnitudes(const std::vector<float> &audioData, double lowerFrequency, double upperFrequency) const;
-    void modifyLogAlternation(std::vector<float> &vec);
-
-    AudioCapture &audioCapture;
-    unsigned int numFrequencyWindows;
-    bool isProcessing;
-    HANDLE processingThreadHandle;
-    DWORD processingThreadId;
-    std::mutex frequencyWindowMagnitudesMutex;
-    std::vector<float> frequencyWindowMagnitudes;
-    std::mutex audioDataMutex;
-    bool packageReady;
+    void deliverSpectrum();
+
+    AudioSource &audioSource;
+    AnalysisPipeline pipeline;
+    std::atomic<bool> isProcessing;
+    std::thread processingThread;
+    std::atomic<bool> packageReady;
+    std::atomic<bool> finished;
     std::mutex readyMutex;
     std::condition_variable cv;
+
+    // Held while delivering, only contended when a sink (un)subscribes
+    std::mutex sinkMutex;
+    std::vector<SpectrumSink *> sinks;
+    // Delivered frame, its vector reaches full size with the first one
+    SpectrumFrame deliveryFrame;
+    // Newest sequence delivered or skipped with no sinks, the base of the Superseded count
+    unsigned long long lastSeenSequence;
 };
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <chrono>
+
+enum class AcquireResult
+{
+    Packet,   // A packet was returned
+    NotReady, // No packet yet, the source is still running
+    Ended,    // The source has ended or was stopped
+};
+
+// Producer of interleaved float sample packets for AudioProcessor. Implemented by
+// the WASAPI loopback capture and by file replay, so the analysis pipeline does
+// not depend on where the audio comes from.
+class AudioSource
+{
+public:
+    virtual ~AudioSource() = default;
+
+    virtual bool initialize() = 0;
+    virtual void startCapture() = 0;
+    virtual void stopCapture() = 0;
+    virtual float getSampleRate() const = 0;
+    virtual unsigned int getChannelCount() const = 0;
+
+    // Blocks until the next packet is available and points samples at it. The view
+    // stays valid until the next call from the same thread. captureTime is when the
+    // newest of the samples was captured. Returns false once the source has ended
+    // or was stopped.
+    virtual bool acquireBuffer(const float *&samples, size_t &numSamples, std::chrono::steady_clock::time_point &captureTime) = 0;
+
+    // Same without blocking, for callers that serve several sources from one thread
+    virtual AcquireResult tryAcquireBuffer(const float *&samples, size_t &numSamples, std::chrono::steady_clock::time_point &captureTime) = 0;
+};
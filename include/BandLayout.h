@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+enum class FrequencyScale
+{
+    Linear,
+    Log,
+    Mel,
+    Bark
+};
+
+// Parses "linear", "log", "mel" or "bark", anything else maps to Log
+FrequencyScale parseFrequencyScale(const std::string &name);
+
+// Maps the bins of a real FFT onto bands evenly spaced on a frequency scale.
+// The layout is a sparse table of fractional bin weights built once per
+// parameter set, bands narrower than a bin interpolate between neighbouring bins.
+class BandLayout
+{
+public:
+    BandLayout();
+
+    // Rebuilds the weight table only when a parameter changed, returns true if it did
+    bool configure(size_t fftSize, double sampleRate, unsigned int numBands, FrequencyScale scale, double lowerFrequency, double upperFrequency);
+
+    unsigned int getNumBands() const;
+    double getBandStartFrequency(unsigned int band) const;
+    double getBandEndFrequency(unsigned int band) const;
+
+    // Weighted average of the magnitudes (fftSize / 2 + 1 bins) in every band
+    void aggregate(const std::vector<float> &magnitudes, std::vector<float> &bands) const;
+
+private:
+    void build();
+
+    size_t fftSize;
+    double sampleRate;
+    unsigned int numBands;
+    FrequencyScale scale;
+    double lowerFrequency;
+    double upperFrequency;
+
+    std::vector<double> bandEdges;
+    std::vector<size_t> bandOffsets;
+    std::vector<unsigned int> weightBins;
+    std::vector<float> weights;
+};
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+struct BarColor
+{
+    float red = 1.0f;
+    float green = 1.0f;
+    float blue = 1.0f;
+    float alpha = 1.0f;
+};
+
+// A bar in pixels with the origin at the bottom left. Bars are spread over the
+// width with a 25 pixel gap, or one as wide as a bar when there are too many for
+// that, and drawn up and down from the horizontal centre line. The edges are
+// whole pixels, so the covered pixels are the ones whose centres are inside and
+// every backend agrees on them without depending on its rasterizer's rounding.
+struct BarRect
+{
+    float left;
+    float right;
+    float bottom;
+    float top;
+};
+
+// Gap before every bar and the bar width in pixels, before rounding. Bar i
+// starts at (i + 1) * gapWidth + i * barWidth.
+struct BarSpacing
+{
+    float gapWidth;
+    float barWidth;
+};
+
+BarSpacing getBarSpacing(size_t numBars, int targetWidth);
+
+// height is a fraction of half the target height
+BarRect getBarRect(size_t index, size_t numBars, int targetWidth, int targetHeight, float height);
+
+// Eases the displayed bar heights towards the latest spectrum with exponential
+// attack and release: t seconds after a change a rising bar has covered
+// 1 - exp(-t / attack) of the way to its target and a falling one
+// 1 - exp(-t / release), so the animation runs at the same speed whatever the
+// frame rate. The defaults move like the former per-frame speeds of 0.7 up and
+// 0.1 down did at 60 frames per second.
+class BarSmoother
+{
+public:
+    static constexpr float defaultAttackSeconds = 0.014f;
+    static constexpr float defaultReleaseSeconds = 0.16f;
+
+    BarSmoother(float attackSeconds = defaultAttackSeconds, float releaseSeconds = defaultReleaseSeconds);
+
+    // Moves every height towards its target by the time passed since the last
+    // update. The first targets, or targets of a different count, are taken as
+    // they are; a time constant of 0 takes them at once.
+    const std::vector<float> &update(const std::vector<float> &targets, float elapsedSeconds);
+    const std::vector<float> &getHeights() const;
+    // True when every height has reached its target, nothing moves until the
+    // targets change
+    bool isSettled() const;
+    void reset();
+
+private:
+    float attackSeconds;
+    float releaseSeconds;
+    bool settled;
+    std::vector<float> heights;
+};
+
+// Draws a frame of bars into some target, a GL context or a CPU framebuffer
+class BarRenderer
+{
+public:
+    virtual ~BarRenderer() = default;
+
+    // Clears the width x height target to transparent and draws one bar per height
+    virtual void render(const std::vector<float> &heights, int width, int height, const BarColor &color) = 0;
+};
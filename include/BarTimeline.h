@@ -0,0 +1,63 @@
+#pragma once
+
+#include "AnalysisPipeline.h"
+#include "BarRenderer.h"
+#include "WavFileSource.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// How the headless tools turn a WAV file into frames of the bar display
+struct BarVideoOptions
+{
+    std::string input;
+    unsigned int fps = 60;
+    int width = 1280;
+    int height = 360;
+    unsigned int numBands = 12;
+    BarColor color;
+    AnalysisSettings settings;
+};
+
+// Parses the options every headless tool takes, --fps, --size, --bands, --fft,
+// --hop, --mode, --rate and --color, and the input file. Any other option is
+// handed to parseToolOption with its value, which reports and returns false for
+// one it does not know or cannot parse. False when an option fails or a value is
+// out of range.
+bool parseBarVideoOptions(int argc, char **argv, BarVideoOptions &options,
+                          const std::function<bool(const std::string &argument, const char *value)> &parseToolOption);
+
+// Plays a WAV file through the analysis pipeline and the bar smoothing as fast as
+// it can be read and hands out the bar heights of every video frame in order.
+// Video frame n shows the audio up to (n + 1) / fps seconds, the bars stay empty
+// until the first spectrum like in the window.
+class BarTimeline
+{
+public:
+    explicit BarTimeline(const BarVideoOptions &options);
+
+    BarTimeline(const BarTimeline &) = delete;
+    BarTimeline &operator=(const BarTimeline &) = delete;
+
+    // Opens the file, false if it is missing or not a supported WAV
+    bool initialize();
+
+    // Heights of the next video frame, false once the audio has run out
+    bool nextFrame(std::vector<float> &heights);
+
+private:
+    std::string input;
+    unsigned int fps;
+    unsigned int numBands;
+    AnalysisSettings settings;
+
+    std::unique_ptr<WavFileSource> source;
+    std::unique_ptr<AnalysisPipeline> pipeline;
+    BarSmoother smoother;
+    SpectrumFrame frame;
+    std::vector<float> targets;
+    unsigned long long framesRead;
+    unsigned long long videoFrame;
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+enum class ChannelMode
+{
+    Downmix,    // Average of all channels
+    PerChannel, // One spectrum per capture channel
+    MidSide,    // (L + R) / 2 and (L - R) / 2 of the first two channels
+};
+
+// Parses "downmix", "perchannel" or "midside", anything else maps to Downmix
+ChannelMode parseChannelMode(const std::string &name);
+
+// Number of planar streams a mode produces for a capture with numChannels channels
+size_t getChannelModeStreamCount(ChannelMode mode, size_t numChannels);
+
+// Split interleaved frames into planar streams according to the mode.
+// planar must hold getChannelModeStreamCount() pointers of numFrames floats each.
+void mixChannels(ChannelMode mode, const float *interleaved, size_t numFrames, size_t numChannels, float *const *planar);
+
+void deinterleave(const float *interleaved, size_t numFrames, size_t numChannels, float *const *planar);
+void downmix(const float *interleaved, size_t numFrames, size_t numChannels, float *mono);
+void midSide(const float *interleaved, size_t numFrames, size_t numChannels, float *mid, float *side);
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "FFT.h"
+#include <vector>
+#include <complex>
+#include <cstddef>
+
+// Streaming constant-Q analysis. numBins bins are spaced geometrically from
+// minFrequency to maxFrequency, so every octave gets the same number of bins.
+// Each bin is evaluated in the most decimated octave of a half-band filterbank
+// that still holds its frequency, with a sparse spectral kernel applied to one
+// short FFT per octave. Bass bins therefore get long kernels without a long FFT.
+class ConstantQ
+{
+public:
+    ConstantQ(double sampleRate, double minFrequency, double maxFrequency, unsigned int numBins, size_t hopSize);
+
+    unsigned int getNumBins() const;
+    double getBinFrequency(unsigned int bin) const;
+
+    // Same protocol as STFTBuffer: push consumes samples up to the next hop,
+    // nextFrame evaluates all bins once a hop has been consumed.
+    size_t push(const float *samples, size_t count);
+
+    // Writes the amplitude of every bin, a full scale sine at a bin frequency reads as 1
+    bool nextFrame(std::vector<float> &magnitudes);
+
+private:
+    struct KernelEntry
+    {
+        unsigned int fftBin;
+        std::complex<float> weight;
+    };
+
+    struct Octave
+    {
+        std::vector<float> ring;
+        size_t writeIndex;
+        // Half-band decimator feeding the next octave
+        std::vector<float> delayLine;
+        size_t delayIndex;
+        bool decimatePhase;
+        std::vector<unsigned int> bins;
+    };
+
+    void writeSample(size_t octave, float sample);
+
+    unsigned int numBins;
+    size_t hopSize;
+    size_t fftSize;
+    size_t samplesSinceFrame;
+    std::vector<double> binFrequencies;
+    std::vector<size_t> kernelOffsets;
+    std::vector<KernelEntry> kernels;
+    std::vector<float> decimatorTaps;
+    std::vector<Octave> octaves;
+
+    FFTPlan fftPlan;
+    std::vector<float> frame;
+    std::vector<std::complex<float>> spectrum;
+};
\ No newline at end of file
@@ -2,5 +2,74 @@
 
 #include <vector>
 #include <complex>
+#include <memory>
 
-std::vector<std::complex<double>> fft(const std::vector<std::complex<double>> &samples);
\ No newline at end of file
+#include "FFTKernels.h"
+
+// Reorders a power of 2 sized vector in place into bit-reversed index order
+void bitReverse(std::vector<std::complex<double>> &data);
+
+std::vector<std::complex<double>> fft(const std::vector<std::complex<double>> &samples);
+
+// Real-input FFT. Returns only the non-redundant bins 0..N/2 (N/2 + 1 values).
+std::vector<std::complex<double>> rfft(const std::vector<float> &samples);
+
+// Precomputed transform for a fixed size. Twiddles and the bit-reversal
+// permutation are built once in the constructor, so execute calls do no trig
+// and no heap allocation once the output buffers are sized.
+// For power of 2 sizes the double overloads are the scalar radix-2 reference
+// and the float overloads run radix-4 passes on the SIMD kernel picked for the
+// running CPU. Other sizes use mixed radix 2/3/5/7 when the size factors into
+// those primes and Bluestein's algorithm otherwise, both in double precision.
+class FFTPlan
+{
+public:
+    explicit FFTPlan(size_t size, FFTKernelType kernelType = detectFFTKernelType());
+
+    size_t getSize() const;
+    bool isPowerOf2() const;
+    // The kernel the plan runs, Scalar when the requested one is not supported
+    FFTKernelType getKernelType() const;
+
+    // Complex transform of getSize() values. in and out may be the same vector.
+    void execute(const std::vector<std::complex<double>> &in, std::vector<std::complex<double>> &out);
+
+    // Real transform of getSize() samples into getSize() / 2 + 1 bins.
+    void executeReal(const std::vector<float> &in, std::vector<std::complex<double>> &out);
+
+    void execute(const std::vector<std::complex<float>> &in, std::vector<std::complex<float>> &out);
+    void executeReal(const std::vector<float> &in, std::vector<std::complex<float>> &out);
+
+private:
+    void permute(const std::vector<size_t> &permutation, const std::vector<std::complex<double>> &in, std::vector<std::complex<double>> &out) const;
+    void butterflies(std::vector<std::complex<double>> &data, size_t n) const;
+    void radixPasses(float *re, float *im, size_t n) const;
+    void initializeArbitrary();
+    void executeArbitrary(const std::complex<double> *in, std::complex<double> *out);
+    void mixedRadix(const std::complex<double> *in, std::complex<double> *out, size_t n, size_t stride, size_t factorIndex) const;
+    void executeBluestein(const std::complex<double> *in, std::complex<double> *out);
+
+    size_t size;
+    std::vector<std::complex<double>> twiddles;
+    std::vector<size_t> bitReversal;
+    std::vector<size_t> halfBitReversal;
+    std::vector<std::complex<double>> scratch;
+
+    FFTKernelType kernelType;
+    Radix4PassFunction radix4Pass;
+    std::vector<float> passTwiddles;
+    std::vector<size_t> passTwiddleOffsets;
+    std::vector<float> realTwiddlesRe;
+    std::vector<float> realTwiddlesIm;
+    std::vector<float> splitRe;
+    std::vector<float> splitIm;
+
+    std::vector<size_t> factors;
+    std::vector<std::complex<double>> rootsOfUnity;
+    std::vector<std::complex<double>> arbitraryInput;
+    std::vector<std::complex<double>> arbitraryOutput;
+    std::unique_ptr<FFTPlan> bluesteinPlan;
+    std::vector<std::complex<double>> bluesteinChirp;
+    std::vector<std::complex<double>> bluesteinFilter;
+    std::vector<std::complex<double>> bluesteinBuffer;
+};
\ No newline at end of file
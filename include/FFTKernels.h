@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+// Instruction sets the float32 FFT butterflies are available for
+enum class FFTKernelType
+{
+    Scalar,
+    SSE2,
+    AVX2,
+    NEON
+};
+
+// One radix-4 (two fused radix-2 stages) pass over split real/imaginary arrays
+// of n values. half is the butterfly span of the first fused stage, w1 holds
+// e^(-2*pi*i*j/(2*half)) and w2 holds e^(-2*pi*i*j/(4*half)) for j < half.
+typedef void (*Radix4PassFunction)(float *re, float *im, size_t n, size_t half,
+                                   const float *w1Re, const float *w1Im,
+                                   const float *w2Re, const float *w2Im);
+
+// Best kernel supported by the running CPU, detected once on first call
+FFTKernelType detectFFTKernelType();
+bool isFFTKernelSupported(FFTKernelType type);
+const char *getFFTKernelName(FFTKernelType type);
+Radix4PassFunction getRadix4Pass(FFTKernelType type);
\ No newline at end of file
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <glad/glad.h>
+#include "BarRenderer.h"
+
+// Fixed-function OpenGL backend, draws into the current context's framebuffer
+class GLBarRenderer : public BarRenderer
+{
+public:
+    void render(const std::vector<float> &heights, int width, int height, const BarColor &color) override;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <glad/glad.h>
+#include "BarRenderer.h"
+
+// Core profile OpenGL 3.3 backend. Every bar is an instance of one quad spanning
+// both mirrored halves. The CPU only uploads one float per bar into a buffer
+// texture, the vertex shader reads its bar's height by gl_InstanceID and lays it
+// out the way getBarRect does, so a frame is one small upload and one draw call.
+// The context it was initialized in must be current for every call, destruction
+// included.
+class GLInstancedBarRenderer : public BarRenderer
+{
+public:
+    GLInstancedBarRenderer();
+    ~GLInstancedBarRenderer() override;
+    GLInstancedBarRenderer(const GLInstancedBarRenderer &) = delete;
+    GLInstancedBarRenderer &operator=(const GLInstancedBarRenderer &) = delete;
+
+    // Compiles the shaders and creates the buffers, false with the reason on
+    // std::cerr when the current context cannot run them. With the context's
+    // loader and ARB_buffer_storage the heights go through a persistently
+    // mapped buffer, otherwise through an orphaned one every frame.
+    bool initialize(GLADloadproc loadProc = nullptr);
+
+    void render(const std::vector<float> &heights, int width, int height, const BarColor &color) override;
+
+    bool isPersistentlyMapped() const;
+
+private:
+    typedef void(APIENTRYP BufferStorageFunction)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+
+    // Frames the persistent buffer holds, the CPU writes one while the GPU may still read the others
+    static const int numRegions = 3;
+
+    void reserveHeights(size_t numBars);
+    void releaseHeightBuffer();
+
+    GLuint program;
+    GLuint vertexArray;
+    GLuint heightBuffer;
+    GLuint heightTexture;
+    GLint targetSizeLocation;
+    GLint spacingLocation;
+    GLint heightOffsetLocation;
+    GLint colorLocation;
+    // Heights a frame has room for, it only grows
+    size_t heightCapacity;
+
+    BufferStorageFunction bufferStorage;
+    float *mappedHeights;
+    GLsync regionFences[numRegions];
+    int currentRegion;
+};
@@ -30,6 +30,23 @@ public:
         return T();
     }
 
+    // defaultValue when the key is missing or does not read as a T
+    template <typename T>
+    T getSetting(const std::string &key, const T &defaultValue) const
+    {
+        auto it = settingsMap.find(key);
+        if (it != settingsMap.end())
+        {
+            T value;
+            std::istringstream iss(it->second);
+            if (iss >> value)
+            {
+                return value;
+            }
+        }
+        return defaultValue;
+    }
+
     template <typename T>
     void setSetting(const std::string &key, const T &value)
     {
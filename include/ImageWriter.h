@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Writers for frames of 8-bit RGBA pixels, rows top to bottom with no padding.
+// False when the file cannot be written.
+bool writeRawImage(const std::string &path, const unsigned char *rgba, int width, int height);
+
+// PNG with rows filtered against the one above and deflated with fixed Huffman
+// codes and run-length matches, which keeps flat images such as the bar display
+// small without depending on zlib
+bool writePNGImage(const std::string &path, const unsigned char *rgba, int width, int height);
+
+// The PNG file contents, for callers that write them elsewhere
+void encodePNGImage(const unsigned char *rgba, int width, int height, std::vector<unsigned char> &png);
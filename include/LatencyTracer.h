@@ -0,0 +1,78 @@
+#pragma once
+
+#include "PeriodicDumper.h"
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+enum class LatencyStage
+{
+    Queue,     // Packet captured until the processor takes it from the source
+    Analysis,  // Packet taken until the spectrum computed from it is published
+    Delivery,  // Spectrum published until it is handed to the window
+    Display,   // Spectrum handed to the window until the frame showing it is swapped
+    EndToEnd,  // Packet captured until the frame showing it is swapped
+    Count,
+};
+
+const char *getLatencyStageName(LatencyStage stage);
+
+struct LatencyStats
+{
+    unsigned long long count;
+    double p50Ms;
+    double p99Ms;
+    double maxMs;
+};
+
+// Lock-free log-linear histogram of durations, eight buckets per power of two so
+// percentiles are within about 6% of the recorded value
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(std::chrono::nanoseconds duration);
+    LatencyStats getStats() const;
+    void reset();
+
+private:
+    static const int subBucketBits = 3;
+    static const int numBuckets = (64 - subBucketBits + 1) << subBucketBits;
+
+    static int getBucketIndex(unsigned long long nanoseconds);
+    static double getBucketMidpoint(int index);
+
+    std::atomic<unsigned long long> buckets[numBuckets];
+    std::atomic<unsigned long long> maxNanoseconds;
+};
+
+// Process-wide latency histograms per pipeline stage. Recording is wait-free and
+// can happen on any thread; an optional background thread dumps the percentiles.
+class LatencyTracer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static LatencyTracer &getInstance();
+
+    ~LatencyTracer();
+
+    // Durations with an unset start (a default constructed time_point) are ignored
+    void record(LatencyStage stage, Clock::time_point start, Clock::time_point end);
+    LatencyStats getStats(LatencyStage stage) const;
+    void reset();
+
+    // Writes one line per stage with samples: name, count, p50, p99 and max in ms
+    void dump(std::ostream &out) const;
+
+    void startPeriodicDump(std::ostream &out, std::chrono::milliseconds interval);
+    void stopPeriodicDump();
+
+private:
+    LatencyTracer();
+
+    LatencyHistogram histograms[static_cast<int>(LatencyStage::Count)];
+
+    PeriodicDumper dumper;
+};
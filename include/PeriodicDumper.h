@@ -0,0 +1,30 @@
+#pragma once
+
+#include <functional>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Background thread that calls a function at a fixed interval until stopped,
+// the periodic dump behind LatencyTracer and PipelineMetrics
+class PeriodicDumper
+{
+public:
+    PeriodicDumper();
+    ~PeriodicDumper();
+
+    PeriodicDumper(const PeriodicDumper &) = delete;
+    PeriodicDumper &operator=(const PeriodicDumper &) = delete;
+
+    // Replaces a running dump. The first call comes one interval after start.
+    void start(std::function<void()> dump, std::chrono::milliseconds interval);
+    // Returns once the thread has exited, a dump in progress finishes first
+    void stop();
+
+private:
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool running;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "PeriodicDumper.h"
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+enum class MetricCounter
+{
+    PacketsCaptured,   // Packets the capture thread received from the device
+    SamplesCaptured,   // Samples written to the capture ring
+    SilentPackets,     // Packets the device flagged as silent, written to the ring as zeros
+    PacketsAnalysed,   // Packets handed to an analysis pipeline
+    FramesAnalysed,    // Spectra computed, one per stream and analysis frame
+    SpectraPublished,  // Spectra published by the pipelines
+    SpectraDelivered,  // Published spectra handed to the window
+    RenderFrames,      // Frames the window swapped
+    StaleRenderFrames, // Swapped frames that showed no new spectrum
+    Count,
+};
+
+enum class DropReason
+{
+    RingOverrun,   // Packet did not fit in the capture ring and was discarded
+    PartialFrame,  // Trailing samples of a packet that do not form a whole interleaved frame
+    Superseded,    // Spectrum replaced by a newer one before the window read it
+    Count,
+};
+
+enum class MetricGauge
+{
+    RingFill,    // Samples waiting in the capture ring when a packet is taken
+    PacketTime,  // Nanoseconds the pipeline spent on one packet
+    RenderTime,  // Nanoseconds spent drawing one frame, the swap excluded
+    Count,
+};
+
+const char *getMetricCounterName(MetricCounter counter);
+const char *getDropReasonName(DropReason reason);
+const char *getMetricGaugeName(MetricGauge gauge);
+
+struct GaugeStats
+{
+    unsigned long long count;
+    long long last;
+    double mean;
+    long long max;
+};
+
+// Process-wide counters and gauges of the capture, analysis and render paths.
+// Updates are relaxed atomic adds and stores on a cache line per metric, so any
+// thread can record without locking or contending with the others. Reads are a
+// snapshot per metric, not across metrics.
+class PipelineMetrics
+{
+public:
+    static PipelineMetrics &getInstance();
+
+    ~PipelineMetrics();
+
+    void increment(MetricCounter counter, unsigned long long amount = 1);
+    void recordDrop(DropReason reason, unsigned long long amount = 1);
+    void recordGauge(MetricGauge gauge, long long value);
+
+    unsigned long long getCounter(MetricCounter counter) const;
+    unsigned long long getDropCount(DropReason reason) const;
+    unsigned long long getTotalDropCount() const;
+    GaugeStats getGaugeStats(MetricGauge gauge) const;
+    void reset();
+
+    // Writes the counters, the drops by reason and one line per gauge with samples
+    void dump(std::ostream &out) const;
+
+    void startPeriodicDump(std::ostream &out, std::chrono::milliseconds interval);
+    void stopPeriodicDump();
+
+private:
+    static const size_t cacheLineSize = 64;
+
+    struct alignas(cacheLineSize) Counter
+    {
+        std::atomic<unsigned long long> value;
+    };
+
+    struct alignas(cacheLineSize) Gauge
+    {
+        std::atomic<unsigned long long> count;
+        std::atomic<long long> last;
+        std::atomic<long long> sum;
+        std::atomic<long long> max;
+    };
+
+    PipelineMetrics();
+
+    Counter counters[static_cast<int>(MetricCounter::Count)];
+    Counter drops[static_cast<int>(DropReason::Count)];
+    Gauge gauges[static_cast<int>(MetricGauge::Count)];
+
+    PeriodicDumper dumper;
+};
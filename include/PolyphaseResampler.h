@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+// Streaming rational resampler for interleaved float samples. The rates are
+// reduced to up/down factors L/M and a Kaiser windowed sinc low-pass at 91% of
+// the lower Nyquist frequency is split into L phases, each output sample is one
+// phase's dot product with the most recent input. About 90 dB of stopband
+// rejection; the filter delays the signal by half its length, 32 input samples
+// when upsampling and 32 output samples when downsampling.
+class PolyphaseResampler
+{
+public:
+    // Throws std::invalid_argument for a zero rate or channel count, or rates whose
+    // ratio needs more than maxPhases filter phases
+    PolyphaseResampler(unsigned int inputRate, unsigned int outputRate, unsigned int numChannels);
+
+    unsigned int getInputRate() const;
+    unsigned int getOutputRate() const;
+    unsigned int getChannelCount() const;
+
+    // Resamples numFrames interleaved frames into output, which is resized to the
+    // frames they complete. Input is buffered across calls, so packet boundaries
+    // do not affect the result.
+    void process(const float *interleaved, size_t numFrames, std::vector<float> &output);
+
+    // Forgets the buffered input, as if the stream started over
+    void reset();
+
+private:
+    static const unsigned int maxPhases = 4096;
+
+    // Moves an output position on to the next output
+    void advance(size_t &position, unsigned int &outputPhase) const;
+
+    unsigned int inputRate;
+    unsigned int outputRate;
+    unsigned int numChannels;
+    unsigned int up;
+    unsigned int down;
+    // down / up as a whole number of input samples and a remainder in phases
+    size_t inputStep;
+    unsigned int phaseStep;
+    size_t tapsPerPhase;
+
+    // Phase p holds its taps in reverse order, so that output sample t is a
+    // forward dot product over the input ending at its position
+    std::vector<float> phases;
+
+    // Planar input per channel, the taps - 1 samples before the next output first
+    std::vector<std::vector<float>> history;
+    size_t nextInput;
+    unsigned int phase;
+};
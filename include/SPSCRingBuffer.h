@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <cstddef>
+
+// Lock-free single-producer/single-consumer ring of samples. The producer writes
+// whole packets or drops them and counts the overrun, it never overwrites data
+// the consumer has not read yet. The consumer can copy samples out, read them in
+// place with peek()/consume(), and block until data arrives. The mutex is only
+// touched when the consumer actually has to sleep.
+class SPSCRingBuffer
+{
+public:
+    explicit SPSCRingBuffer(size_t capacity);
+
+    size_t getCapacity() const;
+
+    // Producer side. Writes all count samples, or none of them when they do not
+    // fit, in which case they are added to the dropped count and false is returned.
+    bool write(const float *samples, size_t count);
+
+    // Consumer side. Number of samples ready to be read.
+    size_t getAvailable() const;
+
+    // Copies up to maxCount samples without blocking and returns how many were read
+    size_t read(float *samples, size_t maxCount);
+
+    // Blocks until at least one sample is available and then reads like read(),
+    // returns 0 once the buffer is closed and drained
+    size_t readBlocking(float *samples, size_t maxCount);
+
+    // Blocks until a sample is available, false once the buffer is closed and drained
+    bool waitForData();
+
+    // Points samples at the longest contiguous run of readable samples without
+    // copying and returns its length. The run stays valid until it is consumed.
+    size_t peek(const float *&samples) const;
+    void consume(size_t count);
+
+    // Wakes a blocked consumer, reads drain what is left and then stop waiting
+    void close();
+    bool isClosed() const;
+
+    // Empties the buffer and reopens it, only while neither side is running
+    void reset();
+
+    unsigned long long getDroppedSampleCount() const;
+    unsigned long long getOverrunCount() const;
+
+private:
+    static const size_t cacheLineSize = 64;
+
+    std::vector<float> ring;
+    size_t capacity;
+
+    // Producer and consumer indices count samples since the last reset and live
+    // on separate cache lines, each side keeps a stale copy of the other's index
+    // so it only reloads the shared one when it looks full or empty
+    alignas(cacheLineSize) std::atomic<unsigned long long> writePosition;
+    unsigned long long cachedReadPosition;
+    std::atomic<unsigned long long> droppedSamples;
+    std::atomic<unsigned long long> overruns;
+
+    alignas(cacheLineSize) std::atomic<unsigned long long> readPosition;
+    mutable unsigned long long cachedWritePosition;
+
+    alignas(cacheLineSize) std::atomic<bool> consumerWaiting;
+    std::atomic<bool> closed;
+    std::mutex waitMutex;
+    std::condition_variable dataAvailable;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "WindowFunction.h"
+#include <vector>
+#include <cstddef>
+
+// Ring buffer that slices a continuous sample stream into overlapping analysis
+// frames of windowSize samples, one frame every hopSize samples, independent of
+// how the stream is split into packets.
+class STFTBuffer
+{
+public:
+    STFTBuffer(size_t windowSize, size_t hopSize);
+
+    size_t getWindowSize() const;
+    size_t getHopSize() const;
+
+    // Appends samples up to the end of the next frame and returns how many were
+    // consumed. Call nextFrame() and push the remainder until everything is consumed.
+    size_t push(const float *samples, size_t count);
+
+    // Copies the next complete frame in chronological order, false if none is ready.
+    bool nextFrame(std::vector<float> &frame);
+
+    // Same as above with the window applied while the frame is copied out of the ring
+    bool nextFrame(std::vector<float> &frame, const WindowFunction &window);
+
+    void reset();
+
+private:
+    size_t windowSize;
+    size_t hopSize;
+    std::vector<float> ring;
+    size_t writeIndex;
+    unsigned long long samplesWritten;
+    unsigned long long nextFrameEnd;
+};
\ No newline at end of file
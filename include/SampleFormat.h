@@ -0,0 +1,27 @@
+#pragma once
+
+#include "FFTKernels.h"
+#include <cstddef>
+
+// Little-endian sample encodings a source can deliver
+enum class SampleFormat
+{
+    Int16,   // Signed 16-bit PCM
+    Int24,   // Signed 24-bit PCM packed in 3 bytes
+    Int32,   // Signed 32-bit PCM, also 24-bit samples left-justified in 32-bit containers
+    Float32, // IEEE float, nominally within -1..1
+};
+
+size_t getSampleFormatSize(SampleFormat format);
+const char *getSampleFormatName(SampleFormat format);
+
+// Converts count samples to floats in -1..1, integers are scaled by 2^-(bits - 1).
+// The input needs no particular alignment.
+typedef void (*SampleConversionFunction)(const unsigned char *in, size_t count, float *out);
+
+// Conversion kernel for a format on an instruction set, the scalar one when the
+// running CPU does not support it. SIMD kernels are picked like the FFT kernels.
+SampleConversionFunction getSampleConversion(SampleFormat format, FFTKernelType kernelType = detectFFTKernelType());
+
+// Converts with the best kernel for the running CPU
+void convertSamples(SampleFormat format, const void *in, size_t count, float *out);
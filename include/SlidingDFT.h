@@ -0,0 +1,43 @@
+#pragma once
+
+#include "BandLayout.h"
+#include <vector>
+#include <complex>
+#include <cstddef>
+
+// Bank of damped sliding DFT resonators, one Hann windowed bin per band.
+// Every input sample updates all bands in O(bands), so the band amplitudes can
+// be read at any moment instead of once per FFT frame. Each band's window length
+// is matched to its bandwidth, capped at maxLength samples.
+class SlidingDFT
+{
+public:
+    SlidingDFT(double sampleRate, unsigned int numBands, FrequencyScale scale, double lowerFrequency, double upperFrequency, size_t maxLength);
+
+    unsigned int getNumBands() const;
+
+    void process(const float *samples, size_t count);
+
+    // Writes the amplitude of every band, a full scale sine at a band centre reads as 1
+    void getMagnitudes(std::vector<float> &magnitudes) const;
+
+private:
+    struct Band
+    {
+        // Resonators at the band centre and one bin either side, combined into a Hann window
+        std::complex<double> state[3];
+        std::complex<double> rotation[3];
+        std::complex<double> delayedRotation;
+        size_t length;
+        double gain;
+    };
+
+    // Runs one chunk that is no longer than the shortest band, so every delayed
+    // sample the chunk needs is already in the history
+    void processChunk(size_t count);
+
+    std::vector<Band> bands;
+    size_t maxChunk;
+    std::vector<float> history;
+    size_t writeIndex;
+};
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "BarRenderer.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// CPU backend that rasterizes into an RGBA8 framebuffer, rows top to bottom.
+// Pixels are covered when their centre lies inside a bar, the rule OpenGL uses,
+// and the colour is written without blending like the GL backend does, so a
+// frame matches what the window shows pixel for pixel.
+class SoftwareBarRenderer : public BarRenderer
+{
+public:
+    SoftwareBarRenderer();
+
+    void render(const std::vector<float> &heights, int width, int height, const BarColor &color) override;
+
+    int getWidth() const;
+    int getHeight() const;
+    // width * height pixels of 4 bytes, red first
+    const unsigned char *getPixels() const;
+
+    // Raw RGBA8 bytes, or an 8-bit RGBA PNG
+    bool saveRaw(const std::string &path) const;
+    bool savePNG(const std::string &path) const;
+
+private:
+    void fillRect(int left, int right, int bottom, int top, uint32_t value);
+
+    int width;
+    int height;
+    std::vector<uint32_t> pixels;
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "BandLayout.h"
+#include "MappedFile.h"
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+// Binary spectrogram files: a fixed header followed by one record per frame of
+// band values, all little-endian.
+//
+//   offset  size  field
+//        0     4  magic "AVSP"
+//        4     2  version, 1
+//        6     1  encoding
+//        7     1  flags, bit 0 set when delta coded
+//        8     4  sample rate
+//       12     4  FFT size
+//       16     4  hop size, samples between frames
+//       20     4  bands per stream
+//       24     4  streams, values per frame = bands * streams
+//       28     1  frequency scale, then 3 bytes padding
+//       32     4  lower frequency, float
+//       36     4  upper frequency, float
+//       40     4  quantization minimum, float
+//       44     4  quantization maximum, float
+//       48     4  sample position of the end of the first frame
+//       52     4  keyframe interval, 0 unless delta coded
+//       56     8  frame count
+//       64     8  index offset, 0 unless delta coded
+//       72        frame records
+//
+// Without delta coding every record has the same size, UInt8/UInt16 values
+// quantized linearly between minimum and maximum or Float16 values as they are.
+// With delta coding every keyframeInterval-th record is stored that way and the
+// ones in between hold the zigzag varint difference of each quantized value to
+// the previous frame. The index at the end lists the file offset of every
+// keyframe as 8 bytes. Frames are a hop apart, so a time maps to a frame and a
+// frame to its keyframe in constant time.
+
+enum class SpectrogramEncoding : uint8_t
+{
+    UInt8,   // 256 linear steps between minimum and maximum
+    UInt16,  // 65536 linear steps between minimum and maximum
+    Float16, // IEEE half precision, the range is ignored, cannot be delta coded
+};
+
+struct SpectrogramHeader
+{
+    uint32_t sampleRate = 0;
+    uint32_t fftSize = 0;
+    uint32_t hopSize = 0;
+    uint32_t numBands = 0;
+    uint32_t numStreams = 1;
+    FrequencyScale frequencyScale = FrequencyScale::Log;
+    float lowerFrequency = 0.0f;
+    float upperFrequency = 0.0f;
+    SpectrogramEncoding encoding = SpectrogramEncoding::UInt8;
+    bool deltaCoded = false;
+    // Values the analysis publishes are log(magnitude + 1) / 8 and stay below 2
+    float minValue = 0.0f;
+    float maxValue = 2.0f;
+    uint32_t firstFrameSample = 0;
+    uint32_t keyframeInterval = 0;
+    uint64_t frameCount = 0;
+
+    uint32_t getValuesPerFrame() const;
+};
+
+// Appends frames to a spectrogram file as they are produced. The header and the
+// index are completed on close(); a file that was never closed can still be read
+// when it is not delta coded.
+class SpectrogramWriter
+{
+public:
+    SpectrogramWriter();
+    ~SpectrogramWriter();
+
+    SpectrogramWriter(const SpectrogramWriter &) = delete;
+    SpectrogramWriter &operator=(const SpectrogramWriter &) = delete;
+
+    // A delta coded header with keyframeInterval 0 gets a keyframe every 64 frames
+    bool open(const std::string &path, const SpectrogramHeader &header);
+    // Takes getValuesPerFrame() values, missing ones are written as the minimum
+    bool writeFrame(const float *values, size_t count);
+    bool close();
+
+    bool isOpen() const;
+    uint64_t getFrameCount() const;
+
+private:
+    std::FILE *file;
+    SpectrogramHeader header;
+    uint64_t bytesWritten;
+    std::vector<uint32_t> quantized;
+    std::vector<uint32_t> previous;
+    std::vector<uint64_t> keyframeOffsets;
+    std::vector<unsigned char> record;
+};
+
+// Reads a spectrogram file through a read-only memory mapping. Sequential reads of
+// a delta coded file decode one frame each, a jump decodes at most a keyframe
+// interval. The decoding cache makes a reader unsafe to share between threads.
+class SpectrogramReader
+{
+public:
+    SpectrogramReader();
+
+    bool open(const std::string &path);
+    void close();
+
+    const SpectrogramHeader &getHeader() const;
+    uint64_t getFrameCount() const;
+
+    // End time of a frame in seconds, and the frame whose end is closest to a time
+    double getFrameTime(uint64_t frame) const;
+    uint64_t getFrameAtTime(double seconds) const;
+
+    bool readFrame(uint64_t frame, std::vector<float> &values) const;
+
+private:
+    bool decodeFrom(uint64_t keyframe, uint64_t frame) const;
+
+    MappedFile file;
+    SpectrogramHeader header;
+    size_t recordSize;
+    const unsigned char *index;
+
+    mutable std::vector<uint32_t> decoded;
+    mutable uint64_t decodedFrame;
+    mutable size_t nextRecordOffset;
+};
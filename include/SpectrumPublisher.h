@@ -0,0 +1,58 @@
+#pragma once
+
+#include "LatencyTracer.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+// Published band values together with the times needed to trace their latency
+struct SpectrumFrame
+{
+    std::vector<float> magnitudes;
+    // When the newest packet that went into the values was captured
+    LatencyTracer::Clock::time_point captureTime;
+    // When the values were published by the processing thread
+    LatencyTracer::Clock::time_point publishTime;
+    // Counts publications from 1, 0 means nothing has been published yet
+    unsigned long long sequence = 0;
+};
+
+// Single writer, many reader publication of the latest spectrum. The writer
+// fills the oldest of three preallocated slots and never waits. Each slot is a
+// seqlock, a reader copies the newest slot and only retries in the rare case the
+// writer came round to that slot again while it was copying. Neither side takes a
+// lock and reads allocate nothing once the frame has reached its full size.
+class SpectrumPublisher
+{
+public:
+    // Frames longer than capacity values are truncated
+    explicit SpectrumPublisher(size_t capacity);
+
+    size_t getCapacity() const;
+
+    // Writer side, only ever called from one thread
+    void publish(const float *magnitudes, size_t count, LatencyTracer::Clock::time_point captureTime, LatencyTracer::Clock::time_point publishTime);
+
+    // Copies the newest frame, false if nothing has been published yet
+    bool read(SpectrumFrame &frame) const;
+
+    unsigned long long getSequence() const;
+
+private:
+    static const int numSlots = 3;
+
+    struct Slot
+    {
+        // Odd while the writer is filling the slot, otherwise twice the publication sequence
+        std::atomic<unsigned long long> version;
+        std::atomic<size_t> count;
+        std::atomic<LatencyTracer::Clock::rep> captureTime;
+        std::atomic<LatencyTracer::Clock::rep> publishTime;
+        std::unique_ptr<std::atomic<float>[]> magnitudes;
+    };
+
+    size_t capacity;
+    Slot slots[numSlots];
+    std::atomic<unsigned long long> sequence;
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "SpectrumPublisher.h"
+
+// Receiver of every spectrum an AudioProcessor publishes, see
+// AudioProcessor::subscribe. Called on the processing thread right after the
+// frame is published; the frame is the processor's own preallocated buffer and
+// only valid during the call. The next packet waits for the call to return, so
+// implementations copy what they need and hand it over without blocking.
+class SpectrumSink
+{
+public:
+    virtual ~SpectrumSink() = default;
+
+    virtual void onSpectrum(const SpectrumFrame &frame) = 0;
+};
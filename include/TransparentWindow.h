@@ -8,16 +8,24 @@
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
+#include <memory>
 
 #include "SystemTrayMenu.h"
 #include "INIFileParser.h"
+#include "LatencyTracer.h"
+#include "GLBarRenderer.h"
+#include "GLInstancedBarRenderer.h"
+#include "SpectrumSink.h"
 
-class TransparentWindow
+class TransparentWindow : public SpectrumSink
 {
 public:
     TransparentWindow();
     ~TransparentWindow();
-    void setBarHeights(const std::vector<float> &heights);
+    // Takes the frame's values as the new bar heights, subscribe the window to an
+    // AudioProcessor to have them pushed. The capture time is traced against the
+    // buffer swap of the first frame that shows them.
+    void onSpectrum(const SpectrumFrame &frame) override;
     void waitForClose();
     bool isRunning() const;
     void waitUntilTransparentWindowIsRunning();
@@ -26,6 +34,8 @@ public:
 private:
     void run();
     void initialize();
+    // Creates the window with its context current and GL loaded, nullptr on failure
+    GLFWwindow *createContextWindow(bool coreProfile);
     static void errorCallback(int error, const char *description);
     GLFWwindow *window;
     std::thread renderThread;
@@ -37,8 +47,17 @@ private:
     int cursorPosX, cursorPosY;
     int offsetCursorPosX, offsetCursorPosY;
     WNDPROC oldWndProc;
-    std::vector<float> prevBarHeights;
-    std::vector<float> barHeights;
+    // Hands spectra from the processing thread to the render thread without
+    // locks; barFrame is the render thread's copy of the newest one
+    SpectrumPublisher spectrumHandoff;
+    SpectrumFrame barFrame;
+    BarSmoother barSmoother;
+    // Instanced in a core profile context, immediate mode otherwise. Created and
+    // destroyed on the render thread, which owns the context.
+    std::unique_ptr<BarRenderer> barRenderer;
+    std::atomic<bool> barHeightsPending;
+    // Set while the render thread sleeps in glfwWaitEvents for new heights
+    std::atomic<bool> renderIdle;
     bool hasBorder;
     bool running;
     std::mutex mutex;
@@ -49,8 +68,8 @@ private:
     int numOfBars;
     int color_red, color_green, color_blue, color_alpha;
 
-    void draw();
-    void drawBars();
+    void draw(float elapsedSeconds);
+    void drawBars(float elapsedSeconds);
     void setBorder(bool border);
     void cursorPositionCallback(GLFWwindow *window, double xpos, double ypos);
     void mouseButtonCallback(GLFWwindow *window, int button, int action, int mods);
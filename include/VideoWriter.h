@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+enum class VideoFormat
+{
+    Y4M,     // YUV4MPEG2, 4:2:0 BT.601 limited range frames as ffmpeg and most players read them
+    RawRGBA, // Bare RGBA8 frames back to back, for ffmpeg -f rawvideo -pix_fmt rgba
+};
+
+// Parses "y4m" or "rgba", false for anything else
+bool parseVideoFormat(const std::string &name, VideoFormat &format);
+
+// Writes an uncompressed video stream. encodeFrame only reads its arguments, so
+// any number of threads can encode frames while one thread writes them in order.
+class VideoWriter
+{
+public:
+    VideoWriter();
+    ~VideoWriter();
+
+    VideoWriter(const VideoWriter &) = delete;
+    VideoWriter &operator=(const VideoWriter &) = delete;
+
+    // "-" writes to standard output, for piping into an encoder
+    bool open(const std::string &path, VideoFormat format, int width, int height, unsigned int fps);
+
+    // Bytes of one encoded frame
+    size_t getFrameSize() const;
+    // Converts width * height RGBA8 pixels, rows top to bottom, into getFrameSize()
+    // bytes of the stream's format. Y4M has no alpha, its pixels are composited
+    // over black.
+    void encodeFrame(const unsigned char *rgba, unsigned char *encoded) const;
+    bool writeFrame(const unsigned char *encoded);
+    bool close();
+
+    bool isOpen() const;
+    uint64_t getFrameCount() const;
+
+private:
+    std::FILE *file;
+    bool ownsFile;
+    VideoFormat format;
+    int width;
+    int height;
+    uint64_t frameCount;
+};
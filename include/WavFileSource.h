@@ -0,0 +1,55 @@
+#pragma once
+
+#include "AudioSource.h"
+#include "MappedFile.h"
+#include "SampleFormat.h"
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+
+enum class ReplayPacing
+{
+    RealTime,        // Hand out each packet when it would have arrived from a live capture
+    AsFastAsPossible, // Hand out packets as soon as they are asked for
+};
+
+// Replays a memory-mapped WAV file as an AudioSource. 32-bit float data is handed
+// out as views straight into the mapping, 16, 24 and 32-bit PCM is converted
+// packet by packet.
+class WavFileSource : public AudioSource
+{
+public:
+    WavFileSource(const std::string &path, ReplayPacing pacing = ReplayPacing::RealTime, size_t framesPerPacket = 480);
+
+    // Maps the file and parses its header, false if it is missing or not a supported WAV
+    bool initialize() override;
+    void startCapture() override;
+    void stopCapture() override;
+    float getSampleRate() const override;
+    unsigned int getChannelCount() const override;
+    bool acquireBuffer(const float *&samples, size_t &numSamples, std::chrono::steady_clock::time_point &captureTime) override;
+    AcquireResult tryAcquireBuffer(const float *&samples, size_t &numSamples, std::chrono::steady_clock::time_point &captureTime) override;
+
+    size_t getFrameCount() const;
+
+private:
+    bool parseHeader();
+    std::chrono::steady_clock::time_point getPacketTime() const;
+
+    std::string path;
+    ReplayPacing pacing;
+    size_t framesPerPacket;
+    MappedFile file;
+
+    const unsigned char *sampleData;
+    size_t frameCount;
+    unsigned int sampleRate;
+    unsigned int channelCount;
+    SampleFormat sampleFormat;
+
+    std::atomic<bool> isCapturing;
+    size_t position;
+    std::chrono::steady_clock::time_point startTime;
+    std::vector<float> convertedBuffer;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+enum class WindowType
+{
+    Rectangular,
+    Hann,
+    Hamming,
+    BlackmanHarris,
+    FlatTop,
+    Kaiser
+};
+
+// Parses "rectangular", "hann", "hamming", "blackmanharris", "flattop" or "kaiser",
+// anything else maps to Hann
+WindowType parseWindowType(const std::string &name);
+
+// Periodic analysis window tabulated once for a frame size. The table is scaled
+// to a coherent gain of 1, so a windowed sine keeps the peak magnitude it would
+// have without a window.
+class WindowFunction
+{
+public:
+    WindowFunction(WindowType type, size_t size, double kaiserBeta = 8.6);
+
+    WindowType getType() const;
+    size_t getSize() const;
+    const std::vector<float> &getTable() const;
+
+    // out[i] = samples[i] * table[offset + i] for i < count
+    void apply(const float *samples, size_t offset, size_t count, float *out) const;
+
+private:
+    WindowType type;
+    std::vector<float> table;
+};
\ No newline at end of file
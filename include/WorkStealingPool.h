@@ -0,0 +1,68 @@
+#pragma once
+
+#include <functional>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstddef>
+
+// Fixed set of worker threads, each with its own task deque. A worker runs its
+// newest task first and, when its deque is empty, steals the oldest task of
+// another worker. Tasks submitted from a worker stay on that worker, so a task
+// that resubmits its own continuation keeps its data in the same cache until
+// someone idle takes it away. A long-running chain that resubmits itself with
+// yield goes behind the tasks already queued on its worker instead, so chains
+// sharing a worker take turns.
+class WorkStealingPool
+{
+public:
+    using Task = std::function<void()>;
+
+    // 0 threads means one per hardware thread
+    explicit WorkStealingPool(size_t numThreads = 0);
+    // Runs the tasks still queued before the workers exit
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    size_t getThreadCount() const;
+
+    void submit(Task task);
+    // Like submit, but from a worker the task runs after every task already
+    // queued on that worker rather than before them
+    void yield(Task task);
+
+    // Blocks until every submitted task, including ones submitted by tasks, has run
+    void waitIdle();
+
+private:
+    // Each deque sits behind its own mutex, only the owner and an occasional
+    // thief ever contend for it
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void push(Task task, bool behindQueued);
+    void run(size_t index);
+    bool popLocal(size_t index, Task &task);
+    bool steal(size_t thief, Task &task);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> nextWorker;
+    std::atomic<size_t> queuedTasks;
+    std::atomic<size_t> pendingTasks;
+    std::atomic<size_t> sleepingWorkers;
+    std::atomic<bool> stopping;
+
+    std::mutex sleepMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+};
@@ -0,0 +1,180 @@
+#include "AnalysisEngine.h"
+
+// Packets a task analyses before it hands its stream back to the pool
+static const int packetsPerTask = 16;
+
+// How long a stream without a ready packet waits before it is polled again
+static const std::chrono::milliseconds parkInterval(1);
+
+AnalysisEngine::Stream::Stream(AudioSource &source, unsigned int numFrequencyWindows, const AnalysisSettings &settings)
+    : source(source),
+      pipeline(numFrequencyWindows, source.getSampleRate(), source.getChannelCount(), settings),
+      finished(false)
+{
+}
+
+AnalysisEngine::AnalysisEngine(size_t numThreads)
+    : pool(numThreads),
+      running(false),
+      activeStreams(0)
+{
+}
+
+AnalysisEngine::~AnalysisEngine()
+{
+    stop();
+}
+
+size_t AnalysisEngine::addStream(AudioSource &source, unsigned int numFrequencyWindows, const AnalysisSettings &settings)
+{
+    streams.emplace_back(new Stream(source, numFrequencyWindows, settings));
+    return streams.size() - 1;
+}
+
+size_t AnalysisEngine::getStreamCount() const
+{
+    return streams.size();
+}
+
+size_t AnalysisEngine::getThreadCount() const
+{
+    return pool.getThreadCount();
+}
+
+void AnalysisEngine::start()
+{
+    if (running)
+    {
+        return;
+    }
+
+    running = true;
+    activeStreams = 0;
+    for (const std::unique_ptr<Stream> &stream : streams)
+    {
+        if (!stream->finished)
+        {
+            ++activeStreams;
+        }
+    }
+    pollThread = std::thread(&AnalysisEngine::pollParkedStreams, this);
+    for (size_t i = 0; i < streams.size(); ++i)
+    {
+        if (!streams[i]->finished)
+        {
+            schedule(i);
+        }
+    }
+}
+
+void AnalysisEngine::stop()
+{
+    if (!running)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(parkedMutex);
+        running = false;
+        parkedStreams.clear();
+        pollCondition.notify_all();
+    }
+    pollThread.join();
+
+    // Tasks still queued see running is false and return without resubmitting
+    pool.waitIdle();
+
+    std::lock_guard<std::mutex> lock(finishedMutex);
+    finishedCondition.notify_all();
+}
+
+bool AnalysisEngine::isFinished() const
+{
+    return activeStreams == 0;
+}
+
+void AnalysisEngine::waitUntilFinished()
+{
+    std::unique_lock<std::mutex> lock(finishedMutex);
+    finishedCondition.wait(lock, [this]()
+                           { return this->isFinished() || !running; });
+}
+
+bool AnalysisEngine::readSpectrum(size_t stream, SpectrumFrame &frame) const
+{
+    return streams[stream]->pipeline.readSpectrum(frame);
+}
+
+const AnalysisPipeline &AnalysisEngine::getPipeline(size_t stream) const
+{
+    return streams[stream]->pipeline;
+}
+
+void AnalysisEngine::schedule(size_t stream)
+{
+    pool.submit([this, stream]()
+                { runStream(stream); });
+}
+
+void AnalysisEngine::runStream(size_t index)
+{
+    if (!running)
+    {
+        return;
+    }
+
+    Stream &stream = *streams[index];
+    for (int i = 0; i < packetsPerTask; ++i)
+    {
+        const float *samples = nullptr;
+        size_t numSamples = 0;
+        LatencyTracer::Clock::time_point captureTime;
+        AcquireResult result = stream.source.tryAcquireBuffer(samples, numSamples, captureTime);
+        if (result == AcquireResult::NotReady)
+        {
+            std::lock_guard<std::mutex> lock(parkedMutex);
+            if (running)
+            {
+                parkedStreams.push_back(index);
+            }
+            return;
+        }
+        if (result == AcquireResult::Ended)
+        {
+            stream.finished = true;
+            if (--activeStreams == 0)
+            {
+                std::lock_guard<std::mutex> lock(finishedMutex);
+                finishedCondition.notify_all();
+            }
+            return;
+        }
+
+        LatencyTracer::Clock::time_point acquireTime = LatencyTracer::Clock::now();
+        LatencyTracer::getInstance().record(LatencyStage::Queue, captureTime, acquireTime);
+        stream.pipeline.processPacket(samples, numSamples, captureTime, acquireTime);
+    }
+
+    // Queue the stream behind the others waiting on this worker so they get their turn
+    pool.yield([this, index]()
+               { runStream(index); });
+}
+
+void AnalysisEngine::pollParkedStreams()
+{
+    std::vector<size_t> ready;
+    std::unique_lock<std::mutex> lock(parkedMutex);
+    while (running)
+    {
+        pollCondition.wait_for(lock, parkInterval);
+        ready.swap(parkedStreams);
+        lock.unlock();
+        for (size_t stream : ready)
+        {
+            schedule(stream);
+        }
+        ready.clear();
+        lock.lock();
+    }
+}
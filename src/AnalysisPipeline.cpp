@@ -0,0 +1,314 @@
+#include "AnalysisPipeline.h"
+#include "PipelineMetrics.h"
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+
+// Frequency range covered by the frequency windows
+static const double lowerFrequency = 40.0;
+static const double upperFrequency = 20000.0;
+
+AnalysisMode parseAnalysisMode(const std::string &name)
+{
+    if (name == "constantq")
+        return AnalysisMode::ConstantQ;
+    if (name == "slidingdft")
+        return AnalysisMode::SlidingDFT;
+    if (name == "auto")
+        return AnalysisMode::Auto;
+    return AnalysisMode::FFT;
+}
+
+// Streams the channel mode can produce, a source that does not know its channel
+// count yet is assumed to have at most eight
+static size_t getMaxStreamCount(ChannelMode mode, unsigned int numChannels)
+{
+    return std::max<size_t>(getChannelModeStreamCount(mode, numChannels != 0 ? numChannels : 8), 1);
+}
+
+AnalysisPipeline::AnalysisPipeline(unsigned int numFrequencyWindows, double sampleRate, unsigned int numChannels, const AnalysisSettings &settings)
+    : numFrequencyWindows(numFrequencyWindows),
+      sampleRate(settings.analysisSampleRate != 0 ? settings.analysisSampleRate : sampleRate),
+      numChannels(std::max<size_t>(numChannels, 1)),
+      settings(settings),
+      activeMode(settings.mode),
+      prepared(false),
+      window(settings.windowType, settings.windowSize),
+      frame(settings.windowSize, 0.0f),
+      fftPlan(settings.windowSize),
+      fftOutput(settings.windowSize / 2 + 1),
+      magnitudes(settings.windowSize / 2 + 1, 0.0f),
+      spectrumPublisher(numFrequencyWindows * getMaxStreamCount(settings.channelMode, numChannels))
+{
+    unsigned int sourceRate = static_cast<unsigned int>(std::lround(sampleRate));
+    if (settings.analysisSampleRate != 0 && settings.analysisSampleRate != sourceRate)
+    {
+        resampler.reset(new PolyphaseResampler(sourceRate, settings.analysisSampleRate, static_cast<unsigned int>(this->numChannels)));
+    }
+}
+
+AnalysisPipeline::ChannelAnalysis::ChannelAnalysis(size_t windowSize, size_t hopSize)
+    : stftBuffer(windowSize, hopSize)
+{
+}
+
+void AnalysisPipeline::prepare()
+{
+    if (prepared)
+    {
+        return;
+    }
+    prepared = true;
+
+    if (settings.mode == AnalysisMode::Auto)
+    {
+        activeMode = chooseCheaperEngine();
+    }
+
+    size_t numStreams = getChannelModeStreamCount(settings.channelMode, numChannels);
+    channels.clear();
+    for (size_t i = 0; i < numStreams; ++i)
+    {
+        channels.emplace_back(settings.windowSize, settings.hopSize);
+        if (activeMode == AnalysisMode::ConstantQ)
+        {
+            channels.back().constantQ.reset(new ConstantQ(sampleRate, lowerFrequency, upperFrequency, numFrequencyWindows, settings.hopSize));
+        }
+        else if (activeMode == AnalysisMode::SlidingDFT)
+        {
+            channels.back().slidingDFT.reset(new SlidingDFT(sampleRate, numFrequencyWindows, settings.frequencyScale, lowerFrequency, upperFrequency, 4 * settings.windowSize));
+        }
+    }
+    planarChannels.assign(numStreams, nullptr);
+}
+
+bool AnalysisPipeline::processPacket(const float *interleaved, size_t numSamples, LatencyTracer::Clock::time_point captureTime, LatencyTracer::Clock::time_point acquireTime)
+{
+    prepare();
+
+    PipelineMetrics &metrics = PipelineMetrics::getInstance();
+    metrics.increment(MetricCounter::PacketsAnalysed);
+
+    // Split the interleaved packet into one planar buffer per analysed stream
+    size_t numFrames = numSamples / numChannels;
+    if (numSamples % numChannels != 0)
+    {
+        metrics.recordDrop(DropReason::PartialFrame);
+    }
+    if (resampler)
+    {
+        resampler->process(interleaved, numFrames, resampled);
+        interleaved = resampled.data();
+        numFrames = resampled.size() / numChannels;
+    }
+    for (size_t i = 0; i < channels.size(); ++i)
+    {
+        channels[i].samples.resize(numFrames);
+        planarChannels[i] = channels[i].samples.data();
+    }
+    mixChannels(settings.channelMode, interleaved, numFrames, numChannels, planarChannels.data());
+
+    // The sliding DFT is updated per sample, publish its state once the whole packet is in
+    if (activeMode == AnalysisMode::SlidingDFT)
+    {
+        for (ChannelAnalysis &channel : channels)
+        {
+            channel.slidingDFT->process(channel.samples.data(), numFrames);
+        }
+        readSlidingDFT();
+        publishFrame(captureTime, acquireTime);
+        return true;
+    }
+
+    // A packet can complete zero, one or several overlapping frames, every stream
+    // receives the same samples so their frames complete together
+    bool published = false;
+    size_t offset = 0;
+    while (offset < numFrames)
+    {
+        size_t consumed = 0;
+        for (ChannelAnalysis &channel : channels)
+        {
+            const float *samples = channel.samples.data() + offset;
+            if (channel.constantQ)
+            {
+                consumed = channel.constantQ->push(samples, numFrames - offset);
+            }
+            else
+            {
+                consumed = channel.stftBuffer.push(samples, numFrames - offset);
+            }
+        }
+        offset += consumed;
+
+        if (analyseFrames())
+        {
+            publishFrame(captureTime, acquireTime);
+            published = true;
+        }
+    }
+    return published;
+}
+
+bool AnalysisPipeline::readSpectrum(SpectrumFrame &frame) const
+{
+    return spectrumPublisher.read(frame);
+}
+
+unsigned long long AnalysisPipeline::getSequence() const
+{
+    return spectrumPublisher.getSequence();
+}
+
+unsigned int AnalysisPipeline::getNumFrequencyWindows() const
+{
+    return numFrequencyWindows;
+}
+
+double AnalysisPipeline::getSampleRate() const
+{
+    return sampleRate;
+}
+
+double AnalysisPipeline::getLowerFrequency() const
+{
+    return lowerFrequency;
+}
+
+double AnalysisPipeline::getUpperFrequency() const
+{
+    return upperFrequency;
+}
+
+AnalysisMode AnalysisPipeline::getActiveMode() const
+{
+    return activeMode;
+}
+
+bool AnalysisPipeline::analyseFrames()
+{
+    // Constant-Q reads amplitudes, scale them to the magnitude range of an FFT frame
+    const float constantQGain = settings.windowSize / 2.0f;
+
+    bool analysed = false;
+    frequencyWindowMagnitudes.resize(channels.size() * numFrequencyWindows);
+    for (size_t i = 0; i < channels.size(); ++i)
+    {
+        ChannelAnalysis &channel = channels[i];
+        if (channel.constantQ)
+        {
+            if (!channel.constantQ->nextFrame(channel.bands))
+            {
+                continue;
+            }
+            for (float &magnitude : channel.bands)
+            {
+                magnitude *= constantQGain;
+            }
+        }
+        else
+        {
+            if (!channel.stftBuffer.nextFrame(frame, window))
+            {
+                continue;
+            }
+            calculateFrequencyWindowMagnitudes(frame, channel.bands);
+        }
+
+        modifyLogAlternation(channel.bands);
+        std::copy(channel.bands.begin(), channel.bands.end(), frequencyWindowMagnitudes.begin() + i * numFrequencyWindows);
+        PipelineMetrics::getInstance().increment(MetricCounter::FramesAnalysed);
+        analysed = true;
+    }
+    return analysed;
+}
+
+void AnalysisPipeline::readSlidingDFT()
+{
+    // Sliding DFT reads amplitudes, scale them to the magnitude range of an FFT frame
+    const float slidingDFTGain = settings.windowSize / 2.0f;
+
+    frequencyWindowMagnitudes.resize(channels.size() * numFrequencyWindows);
+    for (size_t i = 0; i < channels.size(); ++i)
+    {
+        ChannelAnalysis &channel = channels[i];
+        channel.slidingDFT->getMagnitudes(channel.bands);
+        for (float &magnitude : channel.bands)
+        {
+            magnitude *= slidingDFTGain;
+        }
+        modifyLogAlternation(channel.bands);
+        std::copy(channel.bands.begin(), channel.bands.end(), frequencyWindowMagnitudes.begin() + i * numFrequencyWindows);
+    }
+    PipelineMetrics::getInstance().increment(MetricCounter::FramesAnalysed, channels.size());
+}
+
+void AnalysisPipeline::publishFrame(LatencyTracer::Clock::time_point captureTime, LatencyTracer::Clock::time_point acquireTime)
+{
+    LatencyTracer::Clock::time_point publishTime = LatencyTracer::Clock::now();
+    spectrumPublisher.publish(frequencyWindowMagnitudes.data(), frequencyWindowMagnitudes.size(), captureTime, publishTime);
+    PipelineMetrics::getInstance().increment(MetricCounter::SpectraPublished);
+    LatencyTracer::getInstance().record(LatencyStage::Analysis, acquireTime, publishTime);
+}
+
+AnalysisMode AnalysisPipeline::chooseCheaperEngine()
+{
+    // Time both engines on a quarter second of noise at the stream rate
+    std::vector<float> noise(static_cast<size_t>(sampleRate / 4));
+    unsigned int seed = 1;
+    for (float &sample : noise)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        sample = static_cast<float>(seed) / 4294967296.0f - 0.5f;
+    }
+
+    // Setup of either engine is paid once, only the per-sample work is timed. The
+    // band layout would otherwise be built inside the first FFT frame.
+    STFTBuffer buffer(settings.windowSize, settings.hopSize);
+    std::vector<float> bands;
+    bandLayout.configure(settings.windowSize, sampleRate, numFrequencyWindows, settings.frequencyScale, lowerFrequency, upperFrequency);
+    SlidingDFT slidingDFT(sampleRate, numFrequencyWindows, settings.frequencyScale, lowerFrequency, upperFrequency, 4 * settings.windowSize);
+
+    auto start = std::chrono::steady_clock::now();
+    size_t offset = 0;
+    while (offset < noise.size())
+    {
+        offset += buffer.push(noise.data() + offset, noise.size() - offset);
+        if (buffer.nextFrame(frame, window))
+        {
+            calculateFrequencyWindowMagnitudes(frame, bands);
+        }
+    }
+    auto fftTime = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    slidingDFT.process(noise.data(), noise.size());
+    slidingDFT.getMagnitudes(bands);
+    auto slidingDFTTime = std::chrono::steady_clock::now() - start;
+
+    return slidingDFTTime < fftTime ? AnalysisMode::SlidingDFT : AnalysisMode::FFT;
+}
+
+void AnalysisPipeline::calculateFrequencyWindowMagnitudes(const std::vector<float> &audioData, std::vector<float> &output)
+{
+    // Apply the FFT, the input is real so only the first N/2 + 1 bins are computed
+    fftPlan.executeReal(audioData, fftOutput);
+
+    // Calculate magnitudes
+    for (size_t bin = 0; bin < fftOutput.size(); ++bin)
+    {
+        magnitudes[bin] = std::abs(fftOutput[bin]);
+    }
+
+    // Average the bins of each frequency window, the layout is only rebuilt when its parameters change
+    bandLayout.configure(audioData.size(), sampleRate, numFrequencyWindows, settings.frequencyScale, lowerFrequency, upperFrequency);
+    bandLayout.aggregate(magnitudes, output);
+}
+
+void AnalysisPipeline::modifyLogAlternation(std::vector<float> &vec)
+{
+    for (size_t i = 0; i < vec.size(); i++)
+    {
+        vec[i] = std::log(vec[i] + 1) / 8;
+    }
+}
@@ -1,4 +1,6 @@
 #include "AudioCapture.h"
+#include "PipelineMetrics.h"
+#include <mmreg.h>
 #include <stdexcept>
 
 AudioCapture::AudioCapture() : pEnumerator(nullptr),
@@ -6,11 +8,13 @@ AudioCapture::AudioCapture() : pEnumerator(nullptr),
                                pAudioClient(nullptr),
                                pCaptureClient(nullptr),
                                pwfx(nullptr),
+                               sampleFormat(SampleFormat::Float32),
                                captureThreadHandle(nullptr),
                                captureThreadId(0),
                                isCapturing(false),
                                bufferSize(0),
-                               newData(false)
+                               acquiredSamples(0),
+                               latestPacketTime(0)
 {
 }
 
@@ -54,6 +58,26 @@ HRESULT AudioCapture::initializeAudioCapture()
     if (FAILED(hr))
         return hr;
 
+    // Shared mode mix formats are float on most devices but not guaranteed to be
+    WORD formatTag = pwfx->wFormatTag;
+    if (formatTag == WAVE_FORMAT_EXTENSIBLE && pwfx->cbSize >= 22)
+    {
+        // The sub-format GUID starts with the plain format tag
+        formatTag = static_cast<WORD>(reinterpret_cast<WAVEFORMATEXTENSIBLE *>(pwfx)->SubFormat.Data1);
+    }
+    if (formatTag == WAVE_FORMAT_IEEE_FLOAT && pwfx->wBitsPerSample == 32)
+        sampleFormat = SampleFormat::Float32;
+    else if (formatTag == WAVE_FORMAT_PCM && pwfx->wBitsPerSample == 16)
+        sampleFormat = SampleFormat::Int16;
+    else if (formatTag == WAVE_FORMAT_PCM && pwfx->wBitsPerSample == 24)
+        sampleFormat = SampleFormat::Int24;
+    else if (formatTag == WAVE_FORMAT_PCM && pwfx->wBitsPerSample == 32)
+        sampleFormat = SampleFormat::Int32;
+    else
+        return E_FAIL;
+
+    ringBuffer.reset(new SPSCRingBuffer(static_cast<size_t>(pwfx->nSamplesPerSec) * pwfx->nChannels));
+
     hr = pAudioClient->Initialize(AUDCLNT_SHAREMODE_SHARED, AUDCLNT_STREAMFLAGS_LOOPBACK, 0, 0, pwfx, nullptr);
     if (FAILED(hr))
         return hr;
@@ -85,6 +109,8 @@ void AudioCapture::startCapture()
     if (isCapturing)
         return;
 
+    ringBuffer->reset();
+    acquiredSamples = 0;
     isCapturing = true;
     HRESULT hr = pAudioClient->Start();
     if (FAILED(hr))
@@ -100,6 +126,8 @@ void AudioCapture::stopCapture()
 
     isCapturing = false;
     pAudioClient->Stop();
+    // Wake a consumer blocked in acquireBuffer
+    ringBuffer->close();
 
     WaitForSingleObject(captureThreadHandle, INFINITE);
     CloseHandle(captureThreadHandle);
@@ -117,6 +145,11 @@ float AudioCapture::getSampleRate() const
     return static_cast<float>(pwfx->nSamplesPerSec);
 }
 
+unsigned int AudioCapture::getChannelCount() const
+{
+    return pwfx->nChannels;
+}
+
 DWORD WINAPI AudioCapture::captureThread(LPVOID lpParameter)
 {
     AudioCapture *pThis = static_cast<AudioCapture *>(lpParameter);
@@ -143,24 +176,35 @@ void AudioCapture::processAudio()
             hr = pCaptureClient->GetBuffer(&pData, &numFramesToRead, &flags, nullptr, nullptr);
             if (FAILED(hr))
                 break;
+            latestPacketTime.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+            PipelineMetrics &metrics = PipelineMetrics::getInstance();
+            metrics.increment(MetricCounter::PacketsCaptured);
 
-            if (flags & AUDCLNT_BUFFERFLAGS_SILENT)
+            bufferSize = static_cast<size_t>(numFramesToRead) * pwfx->nChannels;
+            if (pData != nullptr || (flags & AUDCLNT_BUFFERFLAGS_SILENT))
             {
-                pData = nullptr;
-            }
-
-            size_t bufferLength = numFramesToRead * pwfx->nBlockAlign;
-            bufferSize = bufferLength / sizeof(float);
-            std::vector<float> tempData(bufferSize);
-            if (pData != nullptr)
-            {
-                std::copy(pData, pData + bufferLength, reinterpret_cast<BYTE *>(tempData.data()));
+                const float *samples = reinterpret_cast<const float *>(pData);
+                if (flags & AUDCLNT_BUFFERFLAGS_SILENT)
+                {
+                    // Silence goes in as zeros, so the spectrum falls and the bars
+                    // come to rest instead of freezing, and the analysis never joins
+                    // audio from either side of a gap
+                    convertedPacket.assign(bufferSize, 0.0f);
+                    samples = convertedPacket.data();
+                    metrics.increment(MetricCounter::SilentPackets);
+                }
+                else if (sampleFormat != SampleFormat::Float32)
                 {
-                    std::unique_lock<std::mutex> lock(outputBufferMutex);
-                    outputBuffer.swap(tempData);
-                    newData = true;
-                    newDataAvailable.notify_one();
+                    convertedPacket.resize(bufferSize);
+                    convertSamples(sampleFormat, pData, bufferSize, convertedPacket.data());
+                    samples = convertedPacket.data();
                 }
+
+                // A full ring drops the whole packet and counts it as an overrun
+                if (ringBuffer->write(samples, bufferSize))
+                    metrics.increment(MetricCounter::SamplesCaptured, bufferSize);
+                else
+                    metrics.recordDrop(DropReason::RingOverrun);
             }
             std::this_thread::sleep_for(std::chrono::milliseconds(8));
 
@@ -175,21 +219,53 @@ void AudioCapture::processAudio()
     }
 }
 
-bool AudioCapture::hasNewData() const
+bool AudioCapture::acquireBuffer(const float *&samples, size_t &numSamples, std::chrono::steady_clock::time_point &captureTime)
+{
+    if (ringBuffer)
+    {
+        // The previous view stays reserved until now so the capture thread cannot overwrite it
+        ringBuffer->consume(acquiredSamples);
+        acquiredSamples = 0;
+        ringBuffer->waitForData();
+    }
+    return tryAcquireBuffer(samples, numSamples, captureTime) == AcquireResult::Packet;
+}
+
+AcquireResult AudioCapture::tryAcquireBuffer(const float *&samples, size_t &numSamples, std::chrono::steady_clock::time_point &captureTime)
 {
-    return newData;
+    samples = nullptr;
+    numSamples = 0;
+    if (!ringBuffer)
+        return AcquireResult::Ended;
+
+    ringBuffer->consume(acquiredSamples);
+    acquiredSamples = 0;
+
+    // Packets are whole frames and the ring holds a whole number of frames, so the
+    // run up to the wrap point never splits a frame
+    acquiredSamples = ringBuffer->peek(samples);
+    if (acquiredSamples == 0)
+    {
+        // Closing happens after the last write, so a closed ring that is still empty is done
+        if (ringBuffer->isClosed() && ringBuffer->getAvailable() == 0)
+            return AcquireResult::Ended;
+        return AcquireResult::NotReady;
+    }
+    numSamples = acquiredSamples;
+    PipelineMetrics::getInstance().recordGauge(MetricGauge::RingFill, static_cast<long long>(ringBuffer->getAvailable()));
+
+    // Read after the ring published the samples, so this is the packet that ends
+    // the view or one written just after it
+    captureTime = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(latestPacketTime.load(std::memory_order_relaxed)));
+    return AcquireResult::Packet;
 }
 
-void AudioCapture::waitUntilNewDataAvailable()
+unsigned long long AudioCapture::getOverrunCount() const
 {
-    std::unique_lock<std::mutex> lock(outputBufferMutex);
-    newDataAvailable.wait(lock, [this]()
-                          { return this->hasNewData(); });
+    return ringBuffer ? ringBuffer->getOverrunCount() : 0;
 }
 
-std::vector<float> AudioCapture::getOutputBuffer()
+unsigned long long AudioCapture::getDroppedSampleCount() const
 {
-    std::unique_lock<std::mutex> lock(outputBufferMutex);
-    newData = false;
-    return outputBuffer;
-}
\ No newline at end of file
+    return ringBuffer ? ringBuffer->getDroppedSampleCount() : 0;
+}
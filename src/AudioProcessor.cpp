@@ -1,17 +1,14 @@
 #include "AudioProcessor.h"
-#include "FFT.h"
-#include <cmath>
-#include <complex>
+#include "PipelineMetrics.h"
 #include <algorithm>
 
-AudioProcessor::AudioProcessor(unsigned int numFrequencyWindows, AudioCapture &audioCapture)
-    : audioCapture(audioCapture),
-      numFrequencyWindows(numFrequencyWindows),
+AudioProcessor::AudioProcessor(unsigned int numFrequencyWindows, AudioSource &audioSource, const AnalysisSettings &settings)
+    : audioSource(audioSource),
+      pipeline(numFrequencyWindows, audioSource.getSampleRate(), audioSource.getChannelCount(), settings),
       isProcessing(false),
-      processingThreadHandle(nullptr),
-      processingThreadId(0),
-      audioDataMutex{},
-      packageReady(false)
+      packageReady(false),
+      finished(false),
+      lastSeenSequence(0)
 {
 }
 
@@ -28,7 +25,8 @@ void AudioProcessor::startProcessing()
     }
 
     isProcessing = true;
-    processingThreadHandle = CreateThread(nullptr, 0, processingThreadEntryPoint, this, 0, &processingThreadId);
+    finished = false;
+    processingThread = std::thread(&AudioProcessor::processAudio, this);
 }
 
 void AudioProcessor::stopProcessing()
@@ -39,113 +37,109 @@ void AudioProcessor::stopProcessing()
     }
 
     isProcessing = false;
-    WaitForSingleObject(processingThreadHandle, INFINITE);
-    CloseHandle(processingThreadHandle);
+    if (processingThread.joinable())
+    {
+        processingThread.join();
+    }
 }
 
 std::vector<float> AudioProcessor::getFrequencyWindowMagnitudes()
 {
-    std::unique_lock<std::mutex> lock(frequencyWindowMagnitudesMutex);
+    return getSpectrumFrame().magnitudes;
+}
+
+SpectrumFrame AudioProcessor::getSpectrumFrame()
+{
     packageReady = false;
-    return frequencyWindowMagnitudes;
+    SpectrumFrame frame;
+    pipeline.readSpectrum(frame);
+    return frame;
 }
 
-DWORD WINAPI AudioProcessor::processingThreadEntryPoint(LPVOID lpParameter)
+bool AudioProcessor::readSpectrum(SpectrumFrame &frame) const
 {
-    AudioProcessor *audioProcessor = static_cast<AudioProcessor *>(lpParameter);
-    audioProcessor->processAudio();
-    return 0;
+    return pipeline.readSpectrum(frame);
 }
 
 void AudioProcessor::processAudio()
 {
-    const double lowerFrequency = 40.0;
-    const double upperFrequency = 20000.0;
+    pipeline.prepare();
 
     while (isProcessing)
     {
-        std::vector<float> audioData(0);
-        {
-            audioCapture.waitUntilNewDataAvailable();
-            audioData = audioCapture.getOutputBuffer();
-        }
-        size_t nextPow2 = 1;
-        while (nextPow2 < audioData.size())
+        const float *audioData = nullptr;
+        size_t numSamples = 0;
+        LatencyTracer::Clock::time_point captureTime;
+        if (!audioSource.acquireBuffer(audioData, numSamples, captureTime))
         {
-            nextPow2 <<= 1;
+            break;
         }
-        size_t bufferSize = audioData.size();
-        if (nextPow2 == 1024)
+        LatencyTracer::Clock::time_point acquireTime = LatencyTracer::Clock::now();
+        LatencyTracer::getInstance().record(LatencyStage::Queue, captureTime, acquireTime);
+
+        bool published = pipeline.processPacket(audioData, numSamples, captureTime, acquireTime);
+        PipelineMetrics::getInstance().recordGauge(MetricGauge::PacketTime, std::chrono::duration_cast<std::chrono::nanoseconds>(LatencyTracer::Clock::now() - acquireTime).count());
+        if (published)
         {
-            std::unique_lock<std::mutex> lock(readyMutex);
-            frequencyWindowMagnitudes = calculateFrequencyWindowMagnitudes(audioData, lowerFrequency, upperFrequency);
-            modifyLogAlternation(frequencyWindowMagnitudes);
-            packageReady = true;
+            deliverSpectrum();
+            // The mutex only orders the flag against a waiter's check, readers never take it
+            {
+                std::unique_lock<std::mutex> lock(readyMutex);
+                packageReady = true;
+            }
+            cv.notify_all();
         }
-        cv.notify_one();
     }
+
+    std::unique_lock<std::mutex> lock(readyMutex);
+    finished = true;
+    cv.notify_all();
 }
 
-std::vector<float> AudioProcessor::calculateFrequencyWindowMagnitudes(const std::vector<float> &audioData, double lowerFrequency, double upperFrequency) const
+void AudioProcessor::deliverSpectrum()
 {
-    std::vector<std::complex<double>> samples(audioData.begin(), audioData.begin() + audioData.size());
-    samples.resize(1024, std::complex<double>(0.0, 0.0));
-
-    // Apply the FFT
-    std::vector<std::complex<double>> fftResult = fft(samples);
-
-    // Calculate magnitudes
-    std::vector<double> magnitudes;
-    for (const std::complex<double> &value : fftResult)
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    if (sinks.empty())
     {
-        magnitudes.push_back(std::abs(value));
+        // Frames nobody listens to are not dropped, they only move the baseline
+        lastSeenSequence = pipeline.getSequence();
+        return;
     }
 
-    // Calculate the frequency window magnitudes
-    std::vector<float> tempFrequencyWindowMagnitudes(numFrequencyWindows, 0);
-    double binWidth = audioCapture.getSampleRate() / static_cast<double>(audioData.size());
-
-    double logLowerFrequency = std::log10(lowerFrequency);
-    double logUpperFrequency = std::log10(upperFrequency);
-    double logRange = logUpperFrequency - logLowerFrequency;
-
-    double scalingFactor = 1.5; // Adjust this value to control the window size growth
-
-    for (unsigned int i = 0; i < numFrequencyWindows; ++i)
+    // A packet can complete several frames, only the newest is delivered
+    pipeline.readSpectrum(deliveryFrame);
+    if (deliveryFrame.sequence > lastSeenSequence + 1)
     {
-        double scaleFactor = 1.0 + (i * (scalingFactor - 1.0)) / (numFrequencyWindows - 1);
-
-        double logWindowStartFrequency = logLowerFrequency + (i * logRange) / (numFrequencyWindows * scaleFactor);
-        double logWindowEndFrequency = logLowerFrequency + ((i + 1) * logRange) / (numFrequencyWindows * scaleFactor);
-
-        double windowStartFrequency = std::pow(10, logWindowStartFrequency);
-        double windowEndFrequency = std::pow(10, logWindowEndFrequency);
-
-        int binStart = static_cast<int>(std::ceil(windowStartFrequency / binWidth));
-        int binEnd = static_cast<int>(std::floor(windowEndFrequency / binWidth));
-
-        double sum = 0.0;
-        for (int bin = binStart; bin <= binEnd; ++bin)
-        {
-            if (bin >= 0 && bin < magnitudes.size())
-            {
-                sum += magnitudes[bin];
-            }
-        }
-        tempFrequencyWindowMagnitudes[i] = static_cast<float>(sum / (binEnd - binStart + 1));
+        PipelineMetrics::getInstance().recordDrop(DropReason::Superseded, deliveryFrame.sequence - lastSeenSequence - 1);
+    }
+    lastSeenSequence = deliveryFrame.sequence;
+    LatencyTracer::getInstance().record(LatencyStage::Delivery, deliveryFrame.publishTime, LatencyTracer::Clock::now());
+    for (SpectrumSink *sink : sinks)
+    {
+        sink->onSpectrum(deliveryFrame);
     }
-
-    return tempFrequencyWindowMagnitudes;
 }
 
-void AudioProcessor::modifyLogAlternation(std::vector<float> &vec)
+void AudioProcessor::subscribe(SpectrumSink &sink)
 {
-    for (int i = 0; i < vec.size(); i++)
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    if (std::find(sinks.begin(), sinks.end(), &sink) == sinks.end())
     {
-        vec[i] = std::log(vec[i] + 1) / 8;
+        sinks.push_back(&sink);
     }
 }
 
+void AudioProcessor::unsubscribe(SpectrumSink &sink)
+{
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    sinks.erase(std::remove(sinks.begin(), sinks.end(), &sink), sinks.end());
+}
+
+AnalysisMode AudioProcessor::getActiveMode() const
+{
+    return pipeline.getActiveMode();
+}
+
 bool AudioProcessor::isReady() const
 {
     return packageReady;
@@ -155,5 +149,24 @@ void AudioProcessor::waitUntilReady()
 {
     std::unique_lock<std::mutex> lock(readyMutex);
     cv.wait(lock, [this]()
-            { return this->isReady(); });
+            { return this->isReady() || this->isFinished(); });
+}
+
+void AudioProcessor::waitForSpectrumAfter(unsigned long long sequence)
+{
+    std::unique_lock<std::mutex> lock(readyMutex);
+    cv.wait(lock, [this, sequence]()
+            { return pipeline.getSequence() > sequence || this->isFinished(); });
+}
+
+bool AudioProcessor::isFinished() const
+{
+    return finished;
+}
+
+void AudioProcessor::waitUntilFinished()
+{
+    std::unique_lock<std::mutex> lock(readyMutex);
+    cv.wait(lock, [this]()
+            { return this->isFinished(); });
 }
@@ -0,0 +1,170 @@
+#include "BandLayout.h"
+#include <cmath>
+#include <algorithm>
+
+static double toScale(double frequency, FrequencyScale scale)
+{
+    switch (scale)
+    {
+    case FrequencyScale::Linear:
+        return frequency;
+    case FrequencyScale::Log:
+        return std::log10(frequency);
+    case FrequencyScale::Mel:
+        return 2595.0 * std::log10(1.0 + frequency / 700.0);
+    case FrequencyScale::Bark:
+        // Traunmueller's approximation, chosen because it has a closed form inverse
+        return 26.81 * frequency / (1960.0 + frequency) - 0.53;
+    }
+    return frequency;
+}
+
+static double fromScale(double value, FrequencyScale scale)
+{
+    switch (scale)
+    {
+    case FrequencyScale::Linear:
+        return value;
+    case FrequencyScale::Log:
+        return std::pow(10.0, value);
+    case FrequencyScale::Mel:
+        return 700.0 * (std::pow(10.0, value / 2595.0) - 1.0);
+    case FrequencyScale::Bark:
+        return 1960.0 * (value + 0.53) / (26.28 - value);
+    }
+    return value;
+}
+
+FrequencyScale parseFrequencyScale(const std::string &name)
+{
+    if (name == "linear")
+        return FrequencyScale::Linear;
+    if (name == "mel")
+        return FrequencyScale::Mel;
+    if (name == "bark")
+        return FrequencyScale::Bark;
+    return FrequencyScale::Log;
+}
+
+BandLayout::BandLayout()
+    : fftSize(0),
+      sampleRate(0.0),
+      numBands(0),
+      scale(FrequencyScale::Log),
+      lowerFrequency(0.0),
+      upperFrequency(0.0)
+{
+}
+
+bool BandLayout::configure(size_t fftSize, double sampleRate, unsigned int numBands, FrequencyScale scale, double lowerFrequency, double upperFrequency)
+{
+    if (fftSize == this->fftSize && sampleRate == this->sampleRate && numBands == this->numBands &&
+        scale == this->scale && lowerFrequency == this->lowerFrequency && upperFrequency == this->upperFrequency)
+    {
+        return false;
+    }
+
+    this->fftSize = fftSize;
+    this->sampleRate = sampleRate;
+    this->numBands = numBands;
+    this->scale = scale;
+    this->lowerFrequency = lowerFrequency;
+    this->upperFrequency = upperFrequency;
+    build();
+    return true;
+}
+
+unsigned int BandLayout::getNumBands() const
+{
+    return numBands;
+}
+
+double BandLayout::getBandStartFrequency(unsigned int band) const
+{
+    return bandEdges[band];
+}
+
+double BandLayout::getBandEndFrequency(unsigned int band) const
+{
+    return bandEdges[band + 1];
+}
+
+void BandLayout::build()
+{
+    bandEdges.assign(numBands + 1, 0.0);
+    bandOffsets.assign(numBands + 1, 0);
+    weightBins.clear();
+    weights.clear();
+
+    if (numBands == 0 || fftSize == 0 || sampleRate <= 0.0)
+    {
+        return;
+    }
+
+    double nyquist = sampleRate / 2.0;
+    double upper = std::min(upperFrequency, nyquist);
+    double lower = std::min(std::max(lowerFrequency, 1.0), upper);
+    double scaledLower = toScale(lower, scale);
+    double scaledUpper = toScale(upper, scale);
+    for (unsigned int i = 0; i <= numBands; ++i)
+    {
+        bandEdges[i] = fromScale(scaledLower + (scaledUpper - scaledLower) * i / numBands, scale);
+    }
+
+    double binWidth = sampleRate / static_cast<double>(fftSize);
+    size_t lastBin = fftSize / 2;
+
+    for (unsigned int i = 0; i < numBands; ++i)
+    {
+        bandOffsets[i] = weights.size();
+
+        // Bin k covers [k - 0.5, k + 0.5) in units of bins
+        double start = bandEdges[i] / binWidth;
+        double end = bandEdges[i + 1] / binWidth;
+        double width = end - start;
+
+        if (width < 1.0)
+        {
+            // Narrower than a bin, interpolate linearly at the band centre
+            double centre = std::min((start + end) / 2.0, static_cast<double>(lastBin));
+            size_t below = static_cast<size_t>(std::floor(centre));
+            double fraction = centre - below;
+            weightBins.push_back(static_cast<unsigned int>(below));
+            weights.push_back(static_cast<float>(1.0 - fraction));
+            if (fraction > 0.0 && below < lastBin)
+            {
+                weightBins.push_back(static_cast<unsigned int>(below + 1));
+                weights.push_back(static_cast<float>(fraction));
+            }
+            continue;
+        }
+
+        // Wider bands average the bins they overlap, partially covered edge bins count fractionally
+        size_t firstBin = static_cast<size_t>(std::floor(start + 0.5));
+        size_t endBin = std::min(static_cast<size_t>(std::floor(end + 0.5)), lastBin);
+        for (size_t bin = firstBin; bin <= endBin; ++bin)
+        {
+            double overlap = std::min(end, bin + 0.5) - std::max(start, bin - 0.5);
+            if (overlap > 0.0)
+            {
+                weightBins.push_back(static_cast<unsigned int>(bin));
+                weights.push_back(static_cast<float>(overlap / width));
+            }
+        }
+    }
+    bandOffsets[numBands] = weights.size();
+}
+
+void BandLayout::aggregate(const std::vector<float> &magnitudes, std::vector<float> &bands) const
+{
+    bands.resize(numBands);
+    for (unsigned int i = 0; i < numBands; ++i)
+    {
+        float sum = 0.0f;
+        for (size_t j = bandOffsets[i]; j < bandOffsets[i + 1]; ++j)
+        {
+            sum += weights[j] * magnitudes[weightBins[j]];
+        }
+        bands[i] = sum;
+    }
+}
@@ -0,0 +1,102 @@
+#include "BarRenderer.h"
+#include <algorithm>
+#include <cmath>
+
+static const float barGapWidth = 25.0f;
+// A thousandth of half the height, under half a pixel for windows up to 1000 pixels tall
+static const float settleDistance = 0.001f;
+
+BarSpacing getBarSpacing(size_t numBars, int targetWidth)
+{
+    // The gap narrows once bars would get thinner than it, so hundreds of bars still fit
+    BarSpacing spacing;
+    spacing.gapWidth = std::min(barGapWidth, static_cast<float>(targetWidth) / (2 * numBars + 1));
+    float totalGapWidth = (numBars + 1) * spacing.gapWidth;
+    spacing.barWidth = (static_cast<float>(targetWidth) - totalGapWidth) / numBars;
+    return spacing;
+}
+
+BarRect getBarRect(size_t index, size_t numBars, int targetWidth, int targetHeight, float height)
+{
+    BarSpacing spacing = getBarSpacing(numBars, targetWidth);
+    float gapWidth = spacing.gapWidth;
+    float barWidth = spacing.barWidth;
+    float x = (index + 1) * gapWidth + index * barWidth;
+    float centre = targetHeight / 2.0f;
+    float halfHeight = std::abs(height) * targetHeight / 2.0f;
+
+    BarRect rect;
+    rect.left = std::round(x);
+    rect.right = std::round(x + barWidth);
+    rect.bottom = std::round(centre - halfHeight);
+    rect.top = std::round(centre + halfHeight);
+    return rect;
+}
+
+BarSmoother::BarSmoother(float attackSeconds, float releaseSeconds)
+    : attackSeconds(attackSeconds),
+      releaseSeconds(releaseSeconds),
+      settled(true)
+{
+}
+
+// Fraction of the remaining distance covered in elapsedSeconds
+static float getSmoothingStep(float timeConstant, float elapsedSeconds)
+{
+    if (timeConstant <= 0.0f)
+    {
+        return 1.0f;
+    }
+    return 1.0f - std::exp(-elapsedSeconds / timeConstant);
+}
+
+const std::vector<float> &BarSmoother::update(const std::vector<float> &targets, float elapsedSeconds)
+{
+    if (heights.size() != targets.size())
+    {
+        heights = targets;
+        settled = true;
+        return heights;
+    }
+
+    float upStep = getSmoothingStep(attackSeconds, elapsedSeconds);
+    float downStep = getSmoothingStep(releaseSeconds, elapsedSeconds);
+    settled = true;
+    for (size_t i = 0; i < targets.size(); ++i)
+    {
+        float heightDiff = targets[i] - heights[i];
+        // An exponential never arrives, closer than this a bar is left at its target
+        if (std::abs(heightDiff) < settleDistance)
+        {
+            heights[i] = targets[i];
+            continue;
+        }
+
+        if (heightDiff > 0)
+        {
+            heights[i] += heightDiff * upStep;
+        }
+        else
+        {
+            heights[i] += heightDiff * downStep;
+        }
+        settled = false;
+    }
+    return heights;
+}
+
+const std::vector<float> &BarSmoother::getHeights() const
+{
+    return heights;
+}
+
+bool BarSmoother::isSettled() const
+{
+    return settled;
+}
+
+void BarSmoother::reset()
+{
+    heights.clear();
+    settled = true;
+}
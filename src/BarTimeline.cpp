@@ -0,0 +1,115 @@
+#include "BarTimeline.h"
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+bool parseBarVideoOptions(int argc, char **argv, BarVideoOptions &options,
+                          const std::function<bool(const std::string &argument, const char *value)> &parseToolOption)
+{
+    size_t hopSize = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (argument.size() > 1 && argument[0] == '-' && !hasValue)
+        {
+            std::cerr << "Missing value for " << argument << std::endl;
+            return false;
+        }
+
+        if (argument == "--fps")
+            options.fps = std::strtoul(argv[++i], nullptr, 10);
+        else if (argument == "--size")
+        {
+            if (std::sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2)
+                return false;
+        }
+        else if (argument == "--bands")
+            options.numBands = std::strtoul(argv[++i], nullptr, 10);
+        else if (argument == "--fft")
+            options.settings.windowSize = std::strtoul(argv[++i], nullptr, 10);
+        else if (argument == "--hop")
+            hopSize = std::strtoul(argv[++i], nullptr, 10);
+        else if (argument == "--mode")
+            options.settings.mode = parseAnalysisMode(argv[++i]);
+        else if (argument == "--rate")
+            options.settings.analysisSampleRate = std::strtoul(argv[++i], nullptr, 10);
+        else if (argument == "--color")
+        {
+            BarColor &color = options.color;
+            if (std::sscanf(argv[++i], "%f,%f,%f,%f", &color.red, &color.green, &color.blue, &color.alpha) < 3)
+                return false;
+        }
+        else if (argument.size() > 1 && argument[0] == '-')
+        {
+            if (!parseToolOption(argument, argv[++i]))
+                return false;
+        }
+        else
+            options.input = argument;
+    }
+
+    options.settings.hopSize = hopSize != 0 ? hopSize : options.settings.windowSize / 4;
+    return !options.input.empty() && options.fps != 0 && options.width > 0 && options.height > 0 && options.numBands != 0 &&
+           options.settings.windowSize != 0 && options.settings.hopSize != 0;
+}
+
+BarTimeline::BarTimeline(const BarVideoOptions &options)
+    : input(options.input),
+      fps(options.fps),
+      numBands(options.numBands),
+      settings(options.settings),
+      framesRead(0),
+      videoFrame(0)
+{
+}
+
+bool BarTimeline::initialize()
+{
+    // Packets no longer than a video frame, so each one crosses at most one frame boundary
+    size_t framesPerPacket;
+    {
+        WavFileSource probe(input);
+        if (!probe.initialize())
+            return false;
+        framesPerPacket = std::max<size_t>(1, probe.getSampleRate() / fps);
+    }
+    source.reset(new WavFileSource(input, ReplayPacing::AsFastAsPossible, framesPerPacket));
+    if (!source->initialize())
+    {
+        source.reset();
+        return false;
+    }
+
+    pipeline.reset(new AnalysisPipeline(numBands, source->getSampleRate(), source->getChannelCount(), settings));
+    source->startCapture();
+    return true;
+}
+
+bool BarTimeline::nextFrame(std::vector<float> &heights)
+{
+    if (!source)
+        return false;
+
+    const float *samples = nullptr;
+    size_t numSamples = 0;
+    LatencyTracer::Clock::time_point captureTime;
+    while (source->tryAcquireBuffer(samples, numSamples, captureTime) == AcquireResult::Packet)
+    {
+        framesRead += numSamples / std::max(source->getChannelCount(), 1u);
+        if (pipeline->processPacket(samples, numSamples, LatencyTracer::Clock::time_point(), LatencyTracer::Clock::time_point()))
+        {
+            pipeline->readSpectrum(frame);
+            targets = frame.magnitudes;
+        }
+
+        if (framesRead * fps < (videoFrame + 1) * source->getSampleRate())
+            continue;
+
+        heights = targets.empty() ? targets : smoother.update(targets, 1.0f / fps);
+        ++videoFrame;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,166 @@
+#include "ChannelMixer.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CHANNEL_MIXER_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define CHANNEL_MIXER_NEON
+#include <arm_neon.h>
+#endif
+
+ChannelMode parseChannelMode(const std::string &name)
+{
+    if (name == "perchannel")
+        return ChannelMode::PerChannel;
+    if (name == "midside")
+        return ChannelMode::MidSide;
+    return ChannelMode::Downmix;
+}
+
+size_t getChannelModeStreamCount(ChannelMode mode, size_t numChannels)
+{
+    switch (mode)
+    {
+    case ChannelMode::PerChannel:
+        return std::max<size_t>(numChannels, 1);
+    case ChannelMode::MidSide:
+        return numChannels >= 2 ? 2 : 1;
+    default:
+        return 1;
+    }
+}
+
+void mixChannels(ChannelMode mode, const float *interleaved, size_t numFrames, size_t numChannels, float *const *planar)
+{
+    if (mode == ChannelMode::PerChannel)
+    {
+        deinterleave(interleaved, numFrames, numChannels, planar);
+    }
+    else if (mode == ChannelMode::MidSide && numChannels >= 2)
+    {
+        midSide(interleaved, numFrames, numChannels, planar[0], planar[1]);
+    }
+    else
+    {
+        downmix(interleaved, numFrames, numChannels, planar[0]);
+    }
+}
+
+void deinterleave(const float *interleaved, size_t numFrames, size_t numChannels, float *const *planar)
+{
+    size_t i = 0;
+    if (numChannels == 2)
+    {
+        float *left = planar[0];
+        float *right = planar[1];
+#if defined(CHANNEL_MIXER_SSE2)
+        for (; i + 4 <= numFrames; i += 4)
+        {
+            __m128 a = _mm_loadu_ps(interleaved + 2 * i);
+            __m128 b = _mm_loadu_ps(interleaved + 2 * i + 4);
+            _mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+#elif defined(CHANNEL_MIXER_NEON)
+        for (; i + 4 <= numFrames; i += 4)
+        {
+            float32x4x2_t lr = vld2q_f32(interleaved + 2 * i);
+            vst1q_f32(left + i, lr.val[0]);
+            vst1q_f32(right + i, lr.val[1]);
+        }
+#endif
+        for (; i < numFrames; ++i)
+        {
+            left[i] = interleaved[2 * i];
+            right[i] = interleaved[2 * i + 1];
+        }
+        return;
+    }
+
+    for (; i < numFrames; ++i)
+    {
+        for (size_t channel = 0; channel < numChannels; ++channel)
+        {
+            planar[channel][i] = interleaved[i * numChannels + channel];
+        }
+    }
+}
+
+void downmix(const float *interleaved, size_t numFrames, size_t numChannels, float *mono)
+{
+    size_t i = 0;
+    if (numChannels == 1)
+    {
+        std::copy(interleaved, interleaved + numFrames, mono);
+        return;
+    }
+
+    if (numChannels == 2)
+    {
+#if defined(CHANNEL_MIXER_SSE2)
+        const __m128 half = _mm_set1_ps(0.5f);
+        for (; i + 4 <= numFrames; i += 4)
+        {
+            __m128 a = _mm_loadu_ps(interleaved + 2 * i);
+            __m128 b = _mm_loadu_ps(interleaved + 2 * i + 4);
+            __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_ps(mono + i, _mm_mul_ps(_mm_add_ps(left, right), half));
+        }
+#elif defined(CHANNEL_MIXER_NEON)
+        for (; i + 4 <= numFrames; i += 4)
+        {
+            float32x4x2_t lr = vld2q_f32(interleaved + 2 * i);
+            vst1q_f32(mono + i, vmulq_n_f32(vaddq_f32(lr.val[0], lr.val[1]), 0.5f));
+        }
+#endif
+    }
+
+    float scale = 1.0f / numChannels;
+    for (; i < numFrames; ++i)
+    {
+        float sum = 0.0f;
+        for (size_t channel = 0; channel < numChannels; ++channel)
+        {
+            sum += interleaved[i * numChannels + channel];
+        }
+        mono[i] = sum * scale;
+    }
+}
+
+void midSide(const float *interleaved, size_t numFrames, size_t numChannels, float *mid, float *side)
+{
+    size_t i = 0;
+    if (numChannels == 2)
+    {
+#if defined(CHANNEL_MIXER_SSE2)
+        const __m128 half = _mm_set1_ps(0.5f);
+        for (; i + 4 <= numFrames; i += 4)
+        {
+            __m128 a = _mm_loadu_ps(interleaved + 2 * i);
+            __m128 b = _mm_loadu_ps(interleaved + 2 * i + 4);
+            __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_ps(mid + i, _mm_mul_ps(_mm_add_ps(left, right), half));
+            _mm_storeu_ps(side + i, _mm_mul_ps(_mm_sub_ps(left, right), half));
+        }
+#elif defined(CHANNEL_MIXER_NEON)
+        for (; i + 4 <= numFrames; i += 4)
+        {
+            float32x4x2_t lr = vld2q_f32(interleaved + 2 * i);
+            vst1q_f32(mid + i, vmulq_n_f32(vaddq_f32(lr.val[0], lr.val[1]), 0.5f));
+            vst1q_f32(side + i, vmulq_n_f32(vsubq_f32(lr.val[0], lr.val[1]), 0.5f));
+        }
+#endif
+    }
+
+    // Front left and right are the first two channels of every WASAPI layout
+    for (; i < numFrames; ++i)
+    {
+        float left = interleaved[i * numChannels];
+        float right = interleaved[i * numChannels + 1];
+        mid[i] = (left + right) * 0.5f;
+        side[i] = (left - right) * 0.5f;
+    }
+}
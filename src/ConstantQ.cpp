@@ -0,0 +1,218 @@
+#include "ConstantQ.h"
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+static const size_t decimatorLength = 63;
+
+// Fraction of an octave's sample rate that its decimated input still passes cleanly
+static const double decimatedPassband = 0.4;
+
+// Spectral kernel entries below this fraction of the kernel peak are dropped
+static const double kernelThreshold = 1e-3;
+
+static size_t nextPowerOf2(size_t n)
+{
+    size_t power = 1;
+    while (power < n)
+    {
+        power <<= 1;
+    }
+    return power;
+}
+
+ConstantQ::ConstantQ(double sampleRate, double minFrequency, double maxFrequency, unsigned int numBins, size_t hopSize)
+    : numBins(numBins),
+      hopSize(hopSize),
+      fftSize(0),
+      samplesSinceFrame(0),
+      fftPlan(1)
+{
+    if (numBins < 2 || hopSize == 0 || minFrequency <= 0.0 || maxFrequency <= minFrequency)
+    {
+        throw std::invalid_argument("ConstantQ needs at least 2 bins over a positive frequency range");
+    }
+    maxFrequency = std::min(maxFrequency, sampleRate * 0.45);
+
+    double ratio = std::pow(maxFrequency / minFrequency, 1.0 / (numBins - 1));
+    double q = 1.0 / (ratio - 1.0);
+
+    // Pick the most decimated octave for each bin and the kernel length it needs there
+    binFrequencies.resize(numBins);
+    std::vector<size_t> binOctave(numBins);
+    std::vector<size_t> kernelLengths(numBins);
+    size_t numOctaves = 1;
+    size_t longestKernel = 1;
+    for (unsigned int k = 0; k < numBins; ++k)
+    {
+        binFrequencies[k] = minFrequency * std::pow(ratio, k);
+        double upperEdge = binFrequencies[k] * std::sqrt(ratio);
+
+        size_t octave = 0;
+        while (upperEdge <= decimatedPassband * sampleRate / static_cast<double>(size_t(2) << octave))
+        {
+            octave++;
+        }
+        binOctave[k] = octave;
+        numOctaves = std::max(numOctaves, octave + 1);
+
+        double octaveRate = sampleRate / static_cast<double>(size_t(1) << octave);
+        kernelLengths[k] = static_cast<size_t>(std::ceil(q * octaveRate / binFrequencies[k]));
+        longestKernel = std::max(longestKernel, kernelLengths[k]);
+    }
+
+    fftSize = nextPowerOf2(longestKernel);
+    fftPlan = FFTPlan(fftSize);
+    frame.resize(fftSize);
+    spectrum.resize(fftSize / 2 + 1);
+
+    // Windowed sinc half-band lowpass with a Blackman window
+    decimatorTaps.resize(decimatorLength);
+    int centre = static_cast<int>(decimatorLength / 2);
+    for (int i = 0; i < static_cast<int>(decimatorLength); ++i)
+    {
+        int n = i - centre;
+        double sinc = n == 0 ? 0.5 : std::sin(M_PI * n / 2.0) / (M_PI * n);
+        double phase = 2.0 * M_PI * i / (decimatorLength - 1);
+        double window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+        decimatorTaps[i] = static_cast<float>(sinc * window);
+    }
+
+    octaves.resize(numOctaves);
+    for (Octave &octave : octaves)
+    {
+        octave.ring.assign(fftSize, 0.0f);
+        octave.writeIndex = 0;
+        octave.delayLine.assign(2 * decimatorLength, 0.0f);
+        octave.delayIndex = 0;
+        octave.decimatePhase = false;
+    }
+
+    // Hann windowed complex exponentials aligned to the newest samples, transformed
+    // once here so each frame only needs a sparse dot product per bin
+    std::vector<std::complex<float>> temporal(fftSize);
+    std::vector<std::complex<float>> kernelSpectrum;
+    for (unsigned int k = 0; k < numBins; ++k)
+    {
+        Octave &octave = octaves[binOctave[k]];
+        octave.bins.push_back(k);
+
+        double octaveRate = sampleRate / static_cast<double>(size_t(1) << binOctave[k]);
+        size_t length = kernelLengths[k];
+        size_t start = fftSize - length;
+        std::fill(temporal.begin(), temporal.end(), std::complex<float>(0.0f, 0.0f));
+        for (size_t n = 0; n < length; ++n)
+        {
+            double window = 0.5 - 0.5 * std::cos(2.0 * M_PI * (n + 0.5) / length);
+            // Scaled so that a unit sine at the bin frequency yields 1
+            double amplitude = 4.0 * window / length;
+            temporal[start + n] = std::polar(static_cast<float>(amplitude), static_cast<float>(2.0 * M_PI * binFrequencies[k] * (start + n) / octaveRate));
+        }
+        fftPlan.execute(temporal, kernelSpectrum);
+
+        // Parseval: sum(x * conj(t)) = sum(X * conj(T)) / fftSize, only bins up to N/2 exist for real input
+        kernelOffsets.push_back(kernels.size());
+        float peak = 0.0f;
+        for (size_t j = 0; j <= fftSize / 2; ++j)
+        {
+            peak = std::max(peak, std::abs(kernelSpectrum[j]));
+        }
+        for (size_t j = 0; j <= fftSize / 2; ++j)
+        {
+            if (std::abs(kernelSpectrum[j]) >= kernelThreshold * peak)
+            {
+                kernels.push_back({static_cast<unsigned int>(j), std::conj(kernelSpectrum[j]) / static_cast<float>(fftSize)});
+            }
+        }
+    }
+    kernelOffsets.push_back(kernels.size());
+}
+
+unsigned int ConstantQ::getNumBins() const
+{
+    return numBins;
+}
+
+double ConstantQ::getBinFrequency(unsigned int bin) const
+{
+    return binFrequencies[bin];
+}
+
+void ConstantQ::writeSample(size_t octaveIndex, float sample)
+{
+    // Each octave feeds every second filtered sample to the next one
+    while (true)
+    {
+        Octave &octave = octaves[octaveIndex];
+        octave.ring[octave.writeIndex] = sample;
+        octave.writeIndex = (octave.writeIndex + 1) % fftSize;
+
+        if (octaveIndex + 1 >= octaves.size())
+        {
+            return;
+        }
+
+        // Doubled delay line so the filter always reads one contiguous span
+        octave.delayLine[octave.delayIndex] = sample;
+        octave.delayLine[octave.delayIndex + decimatorLength] = sample;
+        octave.delayIndex = (octave.delayIndex + 1) % decimatorLength;
+        octave.decimatePhase = !octave.decimatePhase;
+        if (!octave.decimatePhase)
+        {
+            return;
+        }
+
+        const float *history = octave.delayLine.data() + octave.delayIndex;
+        float filtered = 0.0f;
+        for (size_t i = 0; i < decimatorLength; ++i)
+        {
+            filtered += decimatorTaps[i] * history[i];
+        }
+        sample = filtered;
+        octaveIndex++;
+    }
+}
+
+size_t ConstantQ::push(const float *samples, size_t count)
+{
+    size_t toWrite = std::min(count, hopSize - std::min(samplesSinceFrame, hopSize));
+    for (size_t i = 0; i < toWrite; ++i)
+    {
+        writeSample(0, samples[i]);
+    }
+    samplesSinceFrame += toWrite;
+    return toWrite;
+}
+
+bool ConstantQ::nextFrame(std::vector<float> &magnitudes)
+{
+    if (samplesSinceFrame < hopSize)
+    {
+        return false;
+    }
+    samplesSinceFrame = 0;
+
+    magnitudes.resize(numBins);
+    for (const Octave &octave : octaves)
+    {
+        if (octave.bins.empty())
+        {
+            continue;
+        }
+
+        std::copy(octave.ring.begin() + octave.writeIndex, octave.ring.end(), frame.begin());
+        std::copy(octave.ring.begin(), octave.ring.begin() + octave.writeIndex, frame.begin() + (fftSize - octave.writeIndex));
+        fftPlan.executeReal(frame, spectrum);
+
+        for (unsigned int k : octave.bins)
+        {
+            std::complex<float> sum(0.0f, 0.0f);
+            for (size_t j = kernelOffsets[k]; j < kernelOffsets[k + 1]; ++j)
+            {
+                sum += spectrum[kernels[j].fftBin] * kernels[j].weight;
+            }
+            magnitudes[k] = std::abs(sum);
+        }
+    }
+    return true;
+}
@@ -3,11 +3,11 @@
 #include <vector>
 #include <complex>
 #include <algorithm>
+#include <stdexcept>
 
 void bitReverse(std::vector<std::complex<double>> &data)
 {
     size_t n = data.size();
-    size_t log2n = std::log2(n);
     for (size_t i = 1, j = 0; i < n; ++i)
     {
         size_t bit = n >> 1;
@@ -28,11 +28,19 @@ std::vector<std::complex<double>> fft(const std::vector<std::complex<double>> &s
     size_t n = samples.size();
     size_t log2n = std::log2(n);
 
-    if (n & (n - 1)) // Check if n is a power of 2
+    if (n == 0)
     {
         return std::vector<std::complex<double>>();
     }
 
+    if (n & (n - 1)) // Not a power of 2, use the mixed radix / Bluestein plan
+    {
+        std::vector<std::complex<double>> result;
+        FFTPlan plan(n);
+        plan.execute(samples, result);
+        return result;
+    }
+
     std::vector<std::complex<double>> result = samples;
     bitReverse(result);
 
@@ -57,3 +65,443 @@ std::vector<std::complex<double>> fft(const std::vector<std::complex<double>> &s
 
     return result;
 }
+
+std::vector<std::complex<double>> rfft(const std::vector<float> &samples)
+{
+    size_t n = samples.size();
+
+    if (n < 2 || (n & (n - 1))) // Check if n is a power of 2
+    {
+        return std::vector<std::complex<double>>();
+    }
+
+    // Pack even samples into the real part and odd samples into the imaginary part
+    // so that a single half-size complex FFT covers the whole real input.
+    size_t half = n / 2;
+    std::vector<std::complex<double>> packed(half);
+    for (size_t k = 0; k < half; k++)
+    {
+        packed[k] = std::complex<double>(samples[2 * k], samples[2 * k + 1]);
+    }
+
+    std::vector<std::complex<double>> z = fft(packed);
+
+    // Split the half-size spectrum back into the spectrum of the real signal
+    std::vector<std::complex<double>> result(half + 1);
+    for (size_t k = 0; k <= half; k++)
+    {
+        std::complex<double> zk = z[k % half];
+        std::complex<double> zn = std::conj(z[(half - k) % half]);
+        std::complex<double> even = 0.5 * (zk + zn);
+        std::complex<double> odd = std::complex<double>(0, -0.5) * (zk - zn);
+        std::complex<double> w(cos(-2 * M_PI * k / n), sin(-2 * M_PI * k / n));
+        result[k] = even + w * odd;
+    }
+
+    return result;
+}
+
+static std::vector<size_t> bitReversalPermutation(size_t n)
+{
+    std::vector<size_t> permutation(n, 0);
+    for (size_t i = 1, j = 0; i < n; ++i)
+    {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+        {
+            j ^= bit;
+        }
+        j ^= bit;
+        permutation[i] = j;
+    }
+    return permutation;
+}
+
+FFTPlan::FFTPlan(size_t size, FFTKernelType kernelType)
+    : size(size),
+      kernelType(isFFTKernelSupported(kernelType) ? kernelType : FFTKernelType::Scalar),
+      radix4Pass(getRadix4Pass(kernelType))
+{
+    if (size == 0)
+    {
+        throw std::invalid_argument("FFTPlan size must be positive");
+    }
+
+    if (size & (size - 1)) // Not a power of 2
+    {
+        initializeArbitrary();
+        return;
+    }
+
+    // twiddles[k] = e^(-2*pi*i*k/size), every smaller stage uses a strided subset
+    twiddles.resize(size / 2);
+    for (size_t k = 0; k < size / 2; k++)
+    {
+        twiddles[k] = std::polar(1.0, -2 * M_PI * k / size);
+    }
+
+    bitReversal = bitReversalPermutation(size);
+    if (size >= 2)
+    {
+        halfBitReversal = bitReversalPermutation(size / 2);
+        scratch.resize(size / 2);
+    }
+
+    // Twiddles of each radix-4 pass laid out contiguously as w1Re, w1Im, w2Re, w2Im
+    for (size_t half = 1; half * 4 <= size; half <<= 1)
+    {
+        passTwiddleOffsets.push_back(passTwiddles.size());
+        for (int part = 0; part < 4; part++)
+        {
+            for (size_t j = 0; j < half; j++)
+            {
+                std::complex<double> w = std::polar(1.0, -2 * M_PI * j / (part < 2 ? 2 * half : 4 * half));
+                passTwiddles.push_back(static_cast<float>(part % 2 == 0 ? w.real() : w.imag()));
+            }
+        }
+    }
+
+    realTwiddlesRe.resize(size / 2 + 1);
+    realTwiddlesIm.resize(size / 2 + 1);
+    for (size_t k = 0; k <= size / 2; k++)
+    {
+        std::complex<double> w = std::polar(1.0, -2 * M_PI * k / size);
+        realTwiddlesRe[k] = static_cast<float>(w.real());
+        realTwiddlesIm[k] = static_cast<float>(w.imag());
+    }
+
+    splitRe.resize(size);
+    splitIm.resize(size);
+}
+
+void FFTPlan::initializeArbitrary()
+{
+    arbitraryInput.resize(size);
+    arbitraryOutput.resize(size);
+
+    size_t remaining = size;
+    for (size_t radix : {2, 3, 5, 7})
+    {
+        while (remaining % radix == 0)
+        {
+            factors.push_back(radix);
+            remaining /= radix;
+        }
+    }
+
+    if (remaining == 1)
+    {
+        rootsOfUnity.resize(size);
+        for (size_t k = 0; k < size; k++)
+        {
+            rootsOfUnity[k] = std::polar(1.0, -2 * M_PI * k / size);
+        }
+        return;
+    }
+
+    // Bluestein: express the transform as a convolution with a chirp and
+    // evaluate it with a power of 2 transform of at least 2 * size - 1 points
+    factors.clear();
+    size_t convolutionSize = 1;
+    while (convolutionSize < 2 * size - 1)
+    {
+        convolutionSize <<= 1;
+    }
+    bluesteinPlan.reset(new FFTPlan(convolutionSize, kernelType));
+
+    bluesteinChirp.resize(size);
+    for (size_t k = 0; k < size; k++)
+    {
+        // k^2 mod 2 * size keeps the angle small for large k
+        size_t phase = (k * k) % (2 * size);
+        bluesteinChirp[k] = std::polar(1.0, -M_PI * phase / size);
+    }
+
+    bluesteinFilter.assign(convolutionSize, std::complex<double>(0, 0));
+    bluesteinFilter[0] = std::conj(bluesteinChirp[0]);
+    for (size_t k = 1; k < size; k++)
+    {
+        bluesteinFilter[k] = std::conj(bluesteinChirp[k]);
+        bluesteinFilter[convolutionSize - k] = std::conj(bluesteinChirp[k]);
+    }
+    bluesteinPlan->execute(bluesteinFilter, bluesteinFilter);
+    bluesteinBuffer.resize(convolutionSize);
+}
+
+bool FFTPlan::isPowerOf2() const
+{
+    return (size & (size - 1)) == 0;
+}
+
+size_t FFTPlan::getSize() const
+{
+    return size;
+}
+
+FFTKernelType FFTPlan::getKernelType() const
+{
+    return kernelType;
+}
+
+void FFTPlan::permute(const std::vector<size_t> &permutation, const std::vector<std::complex<double>> &in, std::vector<std::complex<double>> &out) const
+{
+    size_t n = permutation.size();
+    if (&in == &out)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            if (i < permutation[i])
+            {
+                std::swap(out[i], out[permutation[i]]);
+            }
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            out[permutation[i]] = in[i];
+        }
+    }
+}
+
+void FFTPlan::butterflies(std::vector<std::complex<double>> &data, size_t n) const
+{
+    for (size_t m = 2; m <= n; m <<= 1)
+    {
+        size_t stride = size / m;
+        size_t halfM = m / 2;
+        for (size_t k = 0; k < n; k += m)
+        {
+            for (size_t j = 0; j < halfM; j++)
+            {
+                std::complex<double> t = twiddles[j * stride] * data[k + j + halfM];
+                std::complex<double> u = data[k + j];
+                data[k + j] = u + t;
+                data[k + j + halfM] = u - t;
+            }
+        }
+    }
+}
+
+void FFTPlan::execute(const std::vector<std::complex<double>> &in, std::vector<std::complex<double>> &out)
+{
+    if (!isPowerOf2())
+    {
+        std::copy(in.begin(), in.begin() + size, arbitraryInput.begin());
+        out.resize(size);
+        executeArbitrary(arbitraryInput.data(), out.data());
+        return;
+    }
+
+    out.resize(size);
+    permute(bitReversal, in, out);
+    butterflies(out, size);
+}
+
+void FFTPlan::executeReal(const std::vector<float> &in, std::vector<std::complex<double>> &out)
+{
+    size_t half = size / 2;
+    out.resize(half + 1);
+
+    if (!isPowerOf2())
+    {
+        std::copy(in.begin(), in.begin() + size, arbitraryInput.begin());
+        executeArbitrary(arbitraryInput.data(), arbitraryOutput.data());
+        std::copy(arbitraryOutput.begin(), arbitraryOutput.begin() + half + 1, out.begin());
+        return;
+    }
+
+    if (half == 0)
+    {
+        out[0] = in[0];
+        return;
+    }
+
+    // Same even/odd packing as rfft(), bit-reversed on the way in
+    for (size_t k = 0; k < half; k++)
+    {
+        scratch[halfBitReversal[k]] = std::complex<double>(in[2 * k], in[2 * k + 1]);
+    }
+    butterflies(scratch, half);
+
+    for (size_t k = 0; k <= half; k++)
+    {
+        std::complex<double> zk = scratch[k == half ? 0 : k];
+        std::complex<double> zn = std::conj(scratch[k == 0 ? 0 : half - k]);
+        std::complex<double> even = 0.5 * (zk + zn);
+        std::complex<double> odd = std::complex<double>(0, -0.5) * (zk - zn);
+        std::complex<double> w = k < half ? twiddles[k] : std::complex<double>(-1, 0);
+        out[k] = even + w * odd;
+    }
+}
+
+void FFTPlan::radixPasses(float *re, float *im, size_t n) const
+{
+    size_t log2n = 0;
+    while ((size_t(1) << log2n) < n)
+    {
+        log2n++;
+    }
+
+    size_t half = 1;
+    size_t level = 0;
+
+    // An odd number of radix-2 stages leaves one over, its twiddle is always 1
+    if (log2n % 2 == 1)
+    {
+        for (size_t k = 0; k < n; k += 2)
+        {
+            float aRe = re[k], aIm = im[k];
+            re[k] = aRe + re[k + 1];
+            im[k] = aIm + im[k + 1];
+            re[k + 1] = aRe - re[k + 1];
+            im[k + 1] = aIm - im[k + 1];
+        }
+        half = 2;
+        level = 1;
+    }
+
+    for (; half * 4 <= n; half <<= 2, level += 2)
+    {
+        const float *w = passTwiddles.data() + passTwiddleOffsets[level];
+        radix4Pass(re, im, n, half, w, w + half, w + 2 * half, w + 3 * half);
+    }
+}
+
+void FFTPlan::execute(const std::vector<std::complex<float>> &in, std::vector<std::complex<float>> &out)
+{
+    if (!isPowerOf2())
+    {
+        std::copy(in.begin(), in.begin() + size, arbitraryInput.begin());
+        executeArbitrary(arbitraryInput.data(), arbitraryOutput.data());
+        out.resize(size);
+        std::copy(arbitraryOutput.begin(), arbitraryOutput.end(), out.begin());
+        return;
+    }
+
+    for (size_t i = 0; i < size; i++)
+    {
+        splitRe[bitReversal[i]] = in[i].real();
+        splitIm[bitReversal[i]] = in[i].imag();
+    }
+    radixPasses(splitRe.data(), splitIm.data(), size);
+
+    out.resize(size);
+    for (size_t i = 0; i < size; i++)
+    {
+        out[i] = std::complex<float>(splitRe[i], splitIm[i]);
+    }
+}
+
+void FFTPlan::executeReal(const std::vector<float> &in, std::vector<std::complex<float>> &out)
+{
+    size_t half = size / 2;
+    out.resize(half + 1);
+
+    if (!isPowerOf2())
+    {
+        std::copy(in.begin(), in.begin() + size, arbitraryInput.begin());
+        executeArbitrary(arbitraryInput.data(), arbitraryOutput.data());
+        std::copy(arbitraryOutput.begin(), arbitraryOutput.begin() + half + 1, out.begin());
+        return;
+    }
+
+    if (half == 0)
+    {
+        out[0] = in[0];
+        return;
+    }
+
+    for (size_t k = 0; k < half; k++)
+    {
+        splitRe[halfBitReversal[k]] = in[2 * k];
+        splitIm[halfBitReversal[k]] = in[2 * k + 1];
+    }
+    radixPasses(splitRe.data(), splitIm.data(), half);
+
+    for (size_t k = 0; k <= half; k++)
+    {
+        size_t i = k == half ? 0 : k;
+        size_t j = k == 0 ? 0 : half - k;
+        float evenRe = 0.5f * (splitRe[i] + splitRe[j]);
+        float evenIm = 0.5f * (splitIm[i] - splitIm[j]);
+        float oddRe = 0.5f * (splitIm[i] + splitIm[j]);
+        float oddIm = -0.5f * (splitRe[i] - splitRe[j]);
+        float wRe = realTwiddlesRe[k], wIm = realTwiddlesIm[k];
+        out[k] = std::complex<float>(evenRe + wRe * oddRe - wIm * oddIm, evenIm + wRe * oddIm + wIm * oddRe);
+    }
+}
+
+void FFTPlan::executeArbitrary(const std::complex<double> *in, std::complex<double> *out)
+{
+    if (bluesteinPlan)
+    {
+        executeBluestein(in, out);
+    }
+    else
+    {
+        mixedRadix(in, out, size, 1, 0);
+    }
+}
+
+void FFTPlan::mixedRadix(const std::complex<double> *in, std::complex<double> *out, size_t n, size_t stride, size_t factorIndex) const
+{
+    if (n == 1)
+    {
+        out[0] = in[0];
+        return;
+    }
+
+    // Decimation in time: transform the p interleaved subsequences, then combine
+    size_t p = factors[factorIndex];
+    size_t m = n / p;
+    for (size_t q = 0; q < p; q++)
+    {
+        mixedRadix(in + q * stride, out + q * m, m, stride * p, factorIndex + 1);
+    }
+
+    // stride is size / n, so rootsOfUnity[q * k * stride] = e^(-2*pi*i*q*k/n)
+    std::complex<double> t[7];
+    for (size_t k = 0; k < m; k++)
+    {
+        for (size_t q = 0; q < p; q++)
+        {
+            t[q] = out[q * m + k] * rootsOfUnity[(q * k * stride) % size];
+        }
+        for (size_t s = 0; s < p; s++)
+        {
+            std::complex<double> sum = t[0];
+            for (size_t q = 1; q < p; q++)
+            {
+                sum += t[q] * rootsOfUnity[(q * s * m * stride) % size];
+            }
+            out[s * m + k] = sum;
+        }
+    }
+}
+
+void FFTPlan::executeBluestein(const std::complex<double> *in, std::complex<double> *out)
+{
+    size_t convolutionSize = bluesteinBuffer.size();
+    for (size_t k = 0; k < size; k++)
+    {
+        bluesteinBuffer[k] = in[k] * bluesteinChirp[k];
+    }
+    std::fill(bluesteinBuffer.begin() + size, bluesteinBuffer.end(), std::complex<double>(0, 0));
+
+    bluesteinPlan->execute(bluesteinBuffer, bluesteinBuffer);
+
+    // Inverse transform through conj(FFT(conj(x))) so the same plan is reused
+    for (size_t k = 0; k < convolutionSize; k++)
+    {
+        bluesteinBuffer[k] = std::conj(bluesteinBuffer[k] * bluesteinFilter[k]);
+    }
+    bluesteinPlan->execute(bluesteinBuffer, bluesteinBuffer);
+
+    double scale = 1.0 / convolutionSize;
+    for (size_t k = 0; k < size; k++)
+    {
+        out[k] = std::conj(bluesteinBuffer[k]) * scale * bluesteinChirp[k];
+    }
+}
@@ -0,0 +1,344 @@
+#include "FFTKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FFT_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define FFT_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(FFT_KERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define FFT_TARGET_SSE2 __attribute__((target("sse2")))
+#define FFT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define FFT_TARGET_SSE2
+#define FFT_TARGET_AVX2
+#endif
+
+static void radix4Scalar(float *re, float *im, size_t n, size_t half,
+                         const float *w1Re, const float *w1Im,
+                         const float *w2Re, const float *w2Im)
+{
+    for (size_t k = 0; k < n; k += 4 * half)
+    {
+        for (size_t j = 0; j < half; j++)
+        {
+            size_t a = k + j;
+            size_t b = a + half;
+            size_t c = b + half;
+            size_t d = c + half;
+
+            // First stage: (a, b) and (c, d) with w1
+            float tRe = w1Re[j] * re[b] - w1Im[j] * im[b];
+            float tIm = w1Re[j] * im[b] + w1Im[j] * re[b];
+            float uRe = w1Re[j] * re[d] - w1Im[j] * im[d];
+            float uIm = w1Re[j] * im[d] + w1Im[j] * re[d];
+            float aRe = re[a] + tRe, aIm = im[a] + tIm;
+            float bRe = re[a] - tRe, bIm = im[a] - tIm;
+            float cRe = re[c] + uRe, cIm = im[c] + uIm;
+            float dRe = re[c] - uRe, dIm = im[c] - uIm;
+
+            // Second stage: (a, c) with w2 and (b, d) with -i * w2
+            float vRe = w2Re[j] * cRe - w2Im[j] * cIm;
+            float vIm = w2Re[j] * cIm + w2Im[j] * cRe;
+            float xRe = w2Im[j] * dRe + w2Re[j] * dIm;
+            float xIm = w2Im[j] * dIm - w2Re[j] * dRe;
+            re[a] = aRe + vRe;
+            im[a] = aIm + vIm;
+            re[c] = aRe - vRe;
+            im[c] = aIm - vIm;
+            re[b] = bRe + xRe;
+            im[b] = bIm + xIm;
+            re[d] = bRe - xRe;
+            im[d] = bIm - xIm;
+        }
+    }
+}
+
+#if defined(FFT_KERNELS_X86)
+FFT_TARGET_SSE2 static void radix4SSE2(float *re, float *im, size_t n, size_t half,
+                                       const float *w1Re, const float *w1Im,
+                                       const float *w2Re, const float *w2Im)
+{
+    if (half % 4 != 0)
+    {
+        radix4Scalar(re, im, n, half, w1Re, w1Im, w2Re, w2Im);
+        return;
+    }
+
+    for (size_t k = 0; k < n; k += 4 * half)
+    {
+        for (size_t j = 0; j < half; j += 4)
+        {
+            size_t a = k + j;
+            size_t b = a + half;
+            size_t c = b + half;
+            size_t d = c + half;
+
+            __m128 w1r = _mm_loadu_ps(w1Re + j), w1i = _mm_loadu_ps(w1Im + j);
+            __m128 w2r = _mm_loadu_ps(w2Re + j), w2i = _mm_loadu_ps(w2Im + j);
+            __m128 ar = _mm_loadu_ps(re + a), ai = _mm_loadu_ps(im + a);
+            __m128 br = _mm_loadu_ps(re + b), bi = _mm_loadu_ps(im + b);
+            __m128 cr = _mm_loadu_ps(re + c), ci = _mm_loadu_ps(im + c);
+            __m128 dr = _mm_loadu_ps(re + d), di = _mm_loadu_ps(im + d);
+
+            __m128 tr = _mm_sub_ps(_mm_mul_ps(w1r, br), _mm_mul_ps(w1i, bi));
+            __m128 ti = _mm_add_ps(_mm_mul_ps(w1r, bi), _mm_mul_ps(w1i, br));
+            __m128 ur = _mm_sub_ps(_mm_mul_ps(w1r, dr), _mm_mul_ps(w1i, di));
+            __m128 ui = _mm_add_ps(_mm_mul_ps(w1r, di), _mm_mul_ps(w1i, dr));
+            br = _mm_sub_ps(ar, tr);
+            bi = _mm_sub_ps(ai, ti);
+            ar = _mm_add_ps(ar, tr);
+            ai = _mm_add_ps(ai, ti);
+            dr = _mm_sub_ps(cr, ur);
+            di = _mm_sub_ps(ci, ui);
+            cr = _mm_add_ps(cr, ur);
+            ci = _mm_add_ps(ci, ui);
+
+            __m128 vr = _mm_sub_ps(_mm_mul_ps(w2r, cr), _mm_mul_ps(w2i, ci));
+            __m128 vi = _mm_add_ps(_mm_mul_ps(w2r, ci), _mm_mul_ps(w2i, cr));
+            __m128 xr = _mm_add_ps(_mm_mul_ps(w2i, dr), _mm_mul_ps(w2r, di));
+            __m128 xi = _mm_sub_ps(_mm_mul_ps(w2i, di), _mm_mul_ps(w2r, dr));
+            _mm_storeu_ps(re + a, _mm_add_ps(ar, vr));
+            _mm_storeu_ps(im + a, _mm_add_ps(ai, vi));
+            _mm_storeu_ps(re + c, _mm_sub_ps(ar, vr));
+            _mm_storeu_ps(im + c, _mm_sub_ps(ai, vi));
+            _mm_storeu_ps(re + b, _mm_add_ps(br, xr));
+            _mm_storeu_ps(im + b, _mm_add_ps(bi, xi));
+            _mm_storeu_ps(re + d, _mm_sub_ps(br, xr));
+            _mm_storeu_ps(im + d, _mm_sub_ps(bi, xi));
+        }
+    }
+}
+
+FFT_TARGET_AVX2 static void radix4AVX2(float *re, float *im, size_t n, size_t half,
+                                       const float *w1Re, const float *w1Im,
+                                       const float *w2Re, const float *w2Im)
+{
+    if (half % 8 != 0)
+    {
+        radix4SSE2(re, im, n, half, w1Re, w1Im, w2Re, w2Im);
+        return;
+    }
+
+    for (size_t k = 0; k < n; k += 4 * half)
+    {
+        for (size_t j = 0; j < half; j += 8)
+        {
+            size_t a = k + j;
+            size_t b = a + half;
+            size_t c = b + half;
+            size_t d = c + half;
+
+            __m256 w1r = _mm256_loadu_ps(w1Re + j), w1i = _mm256_loadu_ps(w1Im + j);
+            __m256 w2r = _mm256_loadu_ps(w2Re + j), w2i = _mm256_loadu_ps(w2Im + j);
+            __m256 ar = _mm256_loadu_ps(re + a), ai = _mm256_loadu_ps(im + a);
+            __m256 br = _mm256_loadu_ps(re + b), bi = _mm256_loadu_ps(im + b);
+            __m256 cr = _mm256_loadu_ps(re + c), ci = _mm256_loadu_ps(im + c);
+            __m256 dr = _mm256_loadu_ps(re + d), di = _mm256_loadu_ps(im + d);
+
+            __m256 tr = _mm256_sub_ps(_mm256_mul_ps(w1r, br), _mm256_mul_ps(w1i, bi));
+            __m256 ti = _mm256_add_ps(_mm256_mul_ps(w1r, bi), _mm256_mul_ps(w1i, br));
+            __m256 ur = _mm256_sub_ps(_mm256_mul_ps(w1r, dr), _mm256_mul_ps(w1i, di));
+            __m256 ui = _mm256_add_ps(_mm256_mul_ps(w1r, di), _mm256_mul_ps(w1i, dr));
+            br = _mm256_sub_ps(ar, tr);
+            bi = _mm256_sub_ps(ai, ti);
+            ar = _mm256_add_ps(ar, tr);
+            ai = _mm256_add_ps(ai, ti);
+            dr = _mm256_sub_ps(cr, ur);
+            di = _mm256_sub_ps(ci, ui);
+            cr = _mm256_add_ps(cr, ur);
+            ci = _mm256_add_ps(ci, ui);
+
+            __m256 vr = _mm256_sub_ps(_mm256_mul_ps(w2r, cr), _mm256_mul_ps(w2i, ci));
+            __m256 vi = _mm256_add_ps(_mm256_mul_ps(w2r, ci), _mm256_mul_ps(w2i, cr));
+            __m256 xr = _mm256_add_ps(_mm256_mul_ps(w2i, dr), _mm256_mul_ps(w2r, di));
+            __m256 xi = _mm256_sub_ps(_mm256_mul_ps(w2i, di), _mm256_mul_ps(w2r, dr));
+            _mm256_storeu_ps(re + a, _mm256_add_ps(ar, vr));
+            _mm256_storeu_ps(im + a, _mm256_add_ps(ai, vi));
+            _mm256_storeu_ps(re + c, _mm256_sub_ps(ar, vr));
+            _mm256_storeu_ps(im + c, _mm256_sub_ps(ai, vi));
+            _mm256_storeu_ps(re + b, _mm256_add_ps(br, xr));
+            _mm256_storeu_ps(im + b, _mm256_add_ps(bi, xi));
+            _mm256_storeu_ps(re + d, _mm256_sub_ps(br, xr));
+            _mm256_storeu_ps(im + d, _mm256_sub_ps(bi, xi));
+        }
+    }
+}
+#endif
+
+#if defined(FFT_KERNELS_NEON)
+static void radix4NEON(float *re, float *im, size_t n, size_t half,
+                       const float *w1Re, const float *w1Im,
+                       const float *w2Re, const float *w2Im)
+{
+    if (half % 4 != 0)
+    {
+        radix4Scalar(re, im, n, half, w1Re, w1Im, w2Re, w2Im);
+        return;
+    }
+
+    for (size_t k = 0; k < n; k += 4 * half)
+    {
+        for (size_t j = 0; j < half; j += 4)
+        {
+            size_t a = k + j;
+            size_t b = a + half;
+            size_t c = b + half;
+            size_t d = c + half;
+
+            float32x4_t w1r = vld1q_f32(w1Re + j), w1i = vld1q_f32(w1Im + j);
+            float32x4_t w2r = vld1q_f32(w2Re + j), w2i = vld1q_f32(w2Im + j);
+            float32x4_t ar = vld1q_f32(re + a), ai = vld1q_f32(im + a);
+            float32x4_t br = vld1q_f32(re + b), bi = vld1q_f32(im + b);
+            float32x4_t cr = vld1q_f32(re + c), ci = vld1q_f32(im + c);
+            float32x4_t dr = vld1q_f32(re + d), di = vld1q_f32(im + d);
+
+            float32x4_t tr = vmlsq_f32(vmulq_f32(w1r, br), w1i, bi);
+            float32x4_t ti = vmlaq_f32(vmulq_f32(w1r, bi), w1i, br);
+            float32x4_t ur = vmlsq_f32(vmulq_f32(w1r, dr), w1i, di);
+            float32x4_t ui = vmlaq_f32(vmulq_f32(w1r, di), w1i, dr);
+            br = vsubq_f32(ar, tr);
+            bi = vsubq_f32(ai, ti);
+            ar = vaddq_f32(ar, tr);
+            ai = vaddq_f32(ai, ti);
+            dr = vsubq_f32(cr, ur);
+            di = vsubq_f32(ci, ui);
+            cr = vaddq_f32(cr, ur);
+            ci = vaddq_f32(ci, ui);
+
+            float32x4_t vr = vmlsq_f32(vmulq_f32(w2r, cr), w2i, ci);
+            float32x4_t vi = vmlaq_f32(vmulq_f32(w2r, ci), w2i, cr);
+            float32x4_t xr = vmlaq_f32(vmulq_f32(w2i, dr), w2r, di);
+            float32x4_t xi = vmlsq_f32(vmulq_f32(w2i, di), w2r, dr);
+            vst1q_f32(re + a, vaddq_f32(ar, vr));
+            vst1q_f32(im + a, vaddq_f32(ai, vi));
+            vst1q_f32(re + c, vsubq_f32(ar, vr));
+            vst1q_f32(im + c, vsubq_f32(ai, vi));
+            vst1q_f32(re + b, vaddq_f32(br, xr));
+            vst1q_f32(im + b, vaddq_f32(bi, xi));
+            vst1q_f32(re + d, vsubq_f32(br, xr));
+            vst1q_f32(im + d, vsubq_f32(bi, xi));
+        }
+    }
+}
+#endif
+
+static bool cpuSupportsAVX2()
+{
+#if defined(FFT_KERNELS_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+    {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(FFT_KERNELS_X86)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+static bool cpuSupportsSSE2()
+{
+#if defined(FFT_KERNELS_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#elif defined(FFT_KERNELS_X86)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#else
+    return false;
+#endif
+}
+
+bool isFFTKernelSupported(FFTKernelType type)
+{
+    switch (type)
+    {
+    case FFTKernelType::Scalar:
+        return true;
+    case FFTKernelType::SSE2:
+        return cpuSupportsSSE2();
+    case FFTKernelType::AVX2:
+        return cpuSupportsAVX2();
+    case FFTKernelType::NEON:
+#if defined(FFT_KERNELS_NEON)
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+FFTKernelType detectFFTKernelType()
+{
+    static const FFTKernelType detected = []()
+    {
+        if (isFFTKernelSupported(FFTKernelType::AVX2))
+            return FFTKernelType::AVX2;
+        if (isFFTKernelSupported(FFTKernelType::SSE2))
+            return FFTKernelType::SSE2;
+        if (isFFTKernelSupported(FFTKernelType::NEON))
+            return FFTKernelType::NEON;
+        return FFTKernelType::Scalar;
+    }();
+    return detected;
+}
+
+const char *getFFTKernelName(FFTKernelType type)
+{
+    switch (type)
+    {
+    case FFTKernelType::Scalar:
+        return "scalar";
+    case FFTKernelType::SSE2:
+        return "sse2";
+    case FFTKernelType::AVX2:
+        return "avx2";
+    case FFTKernelType::NEON:
+        return "neon";
+    }
+    return "unknown";
+}
+
+Radix4PassFunction getRadix4Pass(FFTKernelType type)
+{
+    if (!isFFTKernelSupported(type))
+    {
+        return radix4Scalar;
+    }
+
+    switch (type)
+    {
+#if defined(FFT_KERNELS_X86)
+    case FFTKernelType::SSE2:
+        return radix4SSE2;
+    case FFTKernelType::AVX2:
+        return radix4AVX2;
+#endif
+#if defined(FFT_KERNELS_NEON)
+    case FFTKernelType::NEON:
+        return radix4NEON;
+#endif
+    default:
+        return radix4Scalar;
+    }
+}
@@ -0,0 +1,31 @@
+#include "GLBarRenderer.h"
+
+void GLBarRenderer::render(const std::vector<float> &heights, int width, int height, const BarColor &color)
+{
+    glViewport(0, 0, width, height);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (heights.empty())
+    {
+        return;
+    }
+
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(0, width, 0, height, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    glColor4f(color.red, color.green, color.blue, color.alpha);
+    for (size_t i = 0; i < heights.size(); ++i)
+    {
+        BarRect bar = getBarRect(i, heights.size(), width, height, heights[i]);
+
+        glBegin(GL_QUADS);
+        glVertex2f(bar.left, bar.bottom);
+        glVertex2f(bar.right, bar.bottom);
+        glVertex2f(bar.right, bar.top);
+        glVertex2f(bar.left, bar.top);
+        glEnd();
+    }
+}
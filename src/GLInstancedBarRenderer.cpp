@@ -0,0 +1,278 @@
+#include "GLInstancedBarRenderer.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+// Vertices 0 to 3 are the corners of a triangle strip, the instance is the bar.
+// Its edges follow getBarRect step for step in float, gap and bar width come
+// from getBarSpacing on the CPU, so the GL and software backends cover the same
+// pixels. floor(x + 0.5) is std::round for the on-screen, non-negative edges.
+static const char *vertexShaderSource = R"(#version 330 core
+uniform samplerBuffer heights;
+uniform int heightOffset;
+uniform vec2 targetSize;
+uniform vec2 spacing;
+void main()
+{
+    float index = float(gl_InstanceID);
+    float x = (index + 1.0) * spacing.x + index * spacing.y;
+    float centre = targetSize.y / 2.0;
+    float halfHeight = abs(texelFetch(heights, heightOffset + gl_InstanceID).r) * targetSize.y / 2.0;
+    vec2 low = floor(vec2(x, centre - halfHeight) + 0.5);
+    vec2 high = floor(vec2(x + spacing.y, centre + halfHeight) + 0.5);
+
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    vec2 position = mix(low, high, corner);
+    gl_Position = vec4(position / targetSize * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+static const char *fragmentShaderSource = R"(#version 330 core
+uniform vec4 color;
+out vec4 fragmentColor;
+void main()
+{
+    fragmentColor = color;
+}
+)";
+
+// ARB_buffer_storage, not in the OpenGL 3.3 headers
+static const GLbitfield mapPersistentBit = 0x0040;
+static const GLbitfield mapCoherentBit = 0x0080;
+
+static GLuint compileShader(GLenum type, const char *source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    GLint compiled = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled)
+    {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        std::cerr << "Failed to compile bar shader: " << log << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+static bool hasExtension(const char *name)
+{
+    GLint numExtensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+    for (GLint i = 0; i < numExtensions; ++i)
+    {
+        const char *extension = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension && std::strcmp(extension, name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+GLInstancedBarRenderer::GLInstancedBarRenderer()
+    : program(0),
+      vertexArray(0),
+      heightBuffer(0),
+      heightTexture(0),
+      targetSizeLocation(-1),
+      spacingLocation(-1),
+      heightOffsetLocation(-1),
+      colorLocation(-1),
+      heightCapacity(0),
+      bufferStorage(nullptr),
+      mappedHeights(nullptr),
+      regionFences(),
+      currentRegion(0)
+{
+}
+
+GLInstancedBarRenderer::~GLInstancedBarRenderer()
+{
+    releaseHeightBuffer();
+    if (heightTexture)
+    {
+        glDeleteTextures(1, &heightTexture);
+    }
+    if (vertexArray)
+    {
+        glDeleteVertexArrays(1, &vertexArray);
+    }
+    if (program)
+    {
+        glDeleteProgram(program);
+    }
+}
+
+bool GLInstancedBarRenderer::initialize(GLADloadproc loadProc)
+{
+    if (!GLAD_GL_VERSION_3_3)
+    {
+        std::cerr << "Instanced bar rendering needs OpenGL 3.3" << std::endl;
+        return false;
+    }
+
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+    if (!vertexShader || !fragmentShader)
+    {
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return false;
+    }
+
+    program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        char log[1024];
+        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        std::cerr << "Failed to link bar shader: " << log << std::endl;
+        return false;
+    }
+    targetSizeLocation = glGetUniformLocation(program, "targetSize");
+    spacingLocation = glGetUniformLocation(program, "spacing");
+    heightOffsetLocation = glGetUniformLocation(program, "heightOffset");
+    colorLocation = glGetUniformLocation(program, "color");
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "heights"), 0);
+    glUseProgram(0);
+
+    if (loadProc && hasExtension("GL_ARB_buffer_storage"))
+    {
+        bufferStorage = reinterpret_cast<BufferStorageFunction>(loadProc("glBufferStorage"));
+    }
+
+    // Core profile draws need a vertex array even though nothing comes from attributes
+    glGenVertexArrays(1, &vertexArray);
+    glGenTextures(1, &heightTexture);
+    return true;
+}
+
+bool GLInstancedBarRenderer::isPersistentlyMapped() const
+{
+    return bufferStorage != nullptr;
+}
+
+void GLInstancedBarRenderer::releaseHeightBuffer()
+{
+    for (GLsync &fence : regionFences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (mappedHeights)
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, heightBuffer);
+        glUnmapBuffer(GL_TEXTURE_BUFFER);
+        mappedHeights = nullptr;
+    }
+    if (heightBuffer)
+    {
+        glDeleteBuffers(1, &heightBuffer);
+        heightBuffer = 0;
+    }
+}
+
+void GLInstancedBarRenderer::reserveHeights(size_t numBars)
+{
+    if (numBars <= heightCapacity && heightBuffer)
+    {
+        return;
+    }
+
+    // Persistent storage is immutable, growing means a new buffer
+    releaseHeightBuffer();
+    heightCapacity = std::max(numBars, heightCapacity * 2);
+    glGenBuffers(1, &heightBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, heightBuffer);
+    if (bufferStorage)
+    {
+        GLsizeiptr bufferSize = static_cast<GLsizeiptr>(numRegions * heightCapacity * sizeof(float));
+        GLbitfield flags = GL_MAP_WRITE_BIT | mapPersistentBit | mapCoherentBit;
+        bufferStorage(GL_TEXTURE_BUFFER, bufferSize, nullptr, flags);
+        mappedHeights = static_cast<float *>(glMapBufferRange(GL_TEXTURE_BUFFER, 0, bufferSize, flags));
+        if (!mappedHeights)
+        {
+            std::cerr << "Failed to map the bar height buffer, uploading every frame instead" << std::endl;
+            bufferStorage = nullptr;
+            glDeleteBuffers(1, &heightBuffer);
+            glGenBuffers(1, &heightBuffer);
+            glBindBuffer(GL_TEXTURE_BUFFER, heightBuffer);
+        }
+    }
+    if (!bufferStorage)
+    {
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(heightCapacity * sizeof(float)), nullptr, GL_STREAM_DRAW);
+    }
+
+    glBindTexture(GL_TEXTURE_BUFFER, heightTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, heightBuffer);
+}
+
+void GLInstancedBarRenderer::render(const std::vector<float> &heights, int width, int height, const BarColor &color)
+{
+    glViewport(0, 0, width, height);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (heights.empty() || !program)
+    {
+        return;
+    }
+
+    reserveHeights(heights.size());
+    GLint heightOffset = 0;
+    if (mappedHeights)
+    {
+        // The region was last drawn from numRegions frames ago, normally long done
+        currentRegion = (currentRegion + 1) % numRegions;
+        GLsync &fence = regionFences[currentRegion];
+        if (fence)
+        {
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+        heightOffset = static_cast<GLint>(currentRegion * heightCapacity);
+        std::memcpy(mappedHeights + heightOffset, heights.data(), heights.size() * sizeof(float));
+    }
+    else
+    {
+        // Orphaning the storage lets the driver hand out fresh memory instead of
+        // waiting for the previous frame's draw to finish reading it
+        glBindBuffer(GL_TEXTURE_BUFFER, heightBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(heightCapacity * sizeof(float)), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, static_cast<GLsizeiptr>(heights.size() * sizeof(float)), heights.data());
+    }
+
+    BarSpacing spacing = getBarSpacing(heights.size(), width);
+    glUseProgram(program);
+    glUniform2f(targetSizeLocation, static_cast<float>(width), static_cast<float>(height));
+    glUniform2f(spacingLocation, spacing.gapWidth, spacing.barWidth);
+    glUniform1i(heightOffsetLocation, heightOffset);
+    glUniform4f(colorLocation, color.red, color.green, color.blue, color.alpha);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, heightTexture);
+    glBindVertexArray(vertexArray);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(heights.size()));
+    glBindVertexArray(0);
+
+    if (mappedHeights)
+    {
+        regionFences[currentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
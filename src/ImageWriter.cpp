@@ -0,0 +1,251 @@
+#include "ImageWriter.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+static const unsigned char pngSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+static const unsigned char upFilter = 2;
+
+// Deflate match lengths, from 3 to 258, as length codes 257 to 285 and their extra bits
+static const uint16_t lengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27,
+                                        31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t lengthExtraBits[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                            2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const size_t minMatch = 3;
+static const size_t maxMatch = 258;
+
+static void appendUInt32BE(std::vector<unsigned char> &out, uint32_t value)
+{
+    for (int i = 3; i >= 0; --i)
+        out.push_back(static_cast<unsigned char>(value >> (8 * i)));
+}
+
+static std::vector<uint32_t> makeCRCTable()
+{
+    std::vector<uint32_t> table(256);
+    for (uint32_t n = 0; n < 256; ++n)
+    {
+        uint32_t c = n;
+        for (int k = 0; k < 8; ++k)
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        table[n] = c;
+    }
+    return table;
+}
+
+static uint32_t crc32(const unsigned char *data, size_t size, uint32_t crc = 0)
+{
+    static const std::vector<uint32_t> table = makeCRCTable();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static uint32_t adler32(const unsigned char *data, size_t size)
+{
+    // 5552 bytes is the most that can be summed before the 32-bit sums overflow
+    uint32_t a = 1, b = 0;
+    while (size > 0)
+    {
+        size_t block = std::min<size_t>(size, 5552);
+        for (size_t i = 0; i < block; ++i)
+        {
+            a += data[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        data += block;
+        size -= block;
+    }
+    return (b << 16) | a;
+}
+
+// Deflate packs bits from the least significant end, Huffman codes most significant bit first
+class BitWriter
+{
+public:
+    explicit BitWriter(std::vector<unsigned char> &out) : out(out), buffer(0), count(0) {}
+
+    void writeBits(uint32_t value, int bits)
+    {
+        buffer |= static_cast<uint64_t>(value) << count;
+        count += bits;
+        while (count >= 8)
+        {
+            out.push_back(static_cast<unsigned char>(buffer));
+            buffer >>= 8;
+            count -= 8;
+        }
+    }
+
+    void writeCode(uint32_t code, int bits)
+    {
+        uint32_t reversed = 0;
+        for (int i = 0; i < bits; ++i)
+            reversed |= ((code >> i) & 1) << (bits - 1 - i);
+        writeBits(reversed, bits);
+    }
+
+    void flush()
+    {
+        if (count > 0)
+            out.push_back(static_cast<unsigned char>(buffer));
+        buffer = 0;
+        count = 0;
+    }
+
+private:
+    std::vector<unsigned char> &out;
+    uint64_t buffer;
+    int count;
+};
+
+// The fixed literal/length code of RFC 1951 section 3.2.6
+static void writeFixedSymbol(BitWriter &bits, unsigned int symbol)
+{
+    if (symbol < 144)
+        bits.writeCode(0x30 + symbol, 8);
+    else if (symbol < 256)
+        bits.writeCode(0x190 + symbol - 144, 9);
+    else if (symbol < 280)
+        bits.writeCode(symbol - 256, 7);
+    else
+        bits.writeCode(0xC0 + symbol - 280, 8);
+}
+
+static void writeMatch(BitWriter &bits, size_t length, unsigned int distanceCode)
+{
+    int code = 28;
+    while (lengthBase[code] > length)
+        --code;
+    writeFixedSymbol(bits, 257 + code);
+    bits.writeBits(static_cast<uint32_t>(length - lengthBase[code]), lengthExtraBits[code]);
+    // Distance codes 0 to 3 are distances 1 to 4 with no extra bits
+    bits.writeCode(distanceCode, 5);
+}
+
+static size_t matchLength(const unsigned char *data, size_t size, size_t position, size_t distance)
+{
+    if (position < distance)
+        return 0;
+    size_t limit = std::min(size - position, maxMatch);
+    const unsigned char *current = data + position;
+    const unsigned char *earlier = current - distance;
+    size_t length = 0;
+    // Eight bytes at a time through the long runs of a flat image
+    while (length + 8 <= limit && std::memcmp(current + length, earlier + length, 8) == 0)
+        length += 8;
+    while (length < limit && current[length] == earlier[length])
+        ++length;
+    return length;
+}
+
+// One fixed Huffman block. Only the previous byte and the previous pixel are
+// tried as matches: after the Up filter a row like the one above is all zeroes
+// and a row of flat colour repeats every 4 bytes, which covers nearly all of a
+// bar frame without the cost of a hash chain search.
+static void deflate(const unsigned char *data, size_t size, std::vector<unsigned char> &out)
+{
+    BitWriter bits(out);
+    bits.writeBits(1, 1); // final block
+    bits.writeBits(1, 2); // fixed Huffman codes
+
+    size_t position = 0;
+    while (position < size)
+    {
+        size_t byteRun = matchLength(data, size, position, 1);
+        size_t pixelRun = byteRun < maxMatch ? matchLength(data, size, position, 4) : 0;
+        if (std::max(byteRun, pixelRun) >= minMatch)
+        {
+            bool usePixel = pixelRun > byteRun;
+            size_t length = usePixel ? pixelRun : byteRun;
+            writeMatch(bits, length, usePixel ? 3 : 0);
+            position += length;
+        }
+        else
+        {
+            writeFixedSymbol(bits, data[position]);
+            ++position;
+        }
+    }
+    writeFixedSymbol(bits, 256);
+    bits.flush();
+}
+
+static void appendChunk(std::vector<unsigned char> &png, const char type[4], const std::vector<unsigned char> &data)
+{
+    appendUInt32BE(png, static_cast<uint32_t>(data.size()));
+    size_t typeStart = png.size();
+    png.insert(png.end(), type, type + 4);
+    png.insert(png.end(), data.begin(), data.end());
+    appendUInt32BE(png, crc32(png.data() + typeStart, png.size() - typeStart));
+}
+
+void encodePNGImage(const unsigned char *rgba, int width, int height, std::vector<unsigned char> &png)
+{
+    size_t rowBytes = static_cast<size_t>(width) * 4;
+    std::vector<unsigned char> filtered((rowBytes + 1) * height);
+    for (int y = 0; y < height; ++y)
+    {
+        const unsigned char *row = rgba + y * rowBytes;
+        unsigned char *target = filtered.data() + y * (rowBytes + 1);
+        target[0] = upFilter;
+        if (y == 0)
+        {
+            std::memcpy(target + 1, row, rowBytes);
+            continue;
+        }
+        const unsigned char *above = row - rowBytes;
+        for (size_t x = 0; x < rowBytes; ++x)
+            target[1 + x] = static_cast<unsigned char>(row[x] - above[x]);
+    }
+
+    std::vector<unsigned char> header;
+    appendUInt32BE(header, static_cast<uint32_t>(width));
+    appendUInt32BE(header, static_cast<uint32_t>(height));
+    header.push_back(8); // bit depth
+    header.push_back(6); // RGBA
+    header.push_back(0); // deflate
+    header.push_back(0); // adaptive filtering
+    header.push_back(0); // not interlaced
+
+    // zlib stream: 32K window deflate with no dictionary, then the Adler-32 of the data
+    std::vector<unsigned char> compressed = {0x78, 0x01};
+    compressed.reserve(filtered.size() / 8);
+    deflate(filtered.data(), filtered.size(), compressed);
+    appendUInt32BE(compressed, adler32(filtered.data(), filtered.size()));
+
+    png.assign(pngSignature, pngSignature + sizeof(pngSignature));
+    appendChunk(png, "IHDR", header);
+    appendChunk(png, "IDAT", compressed);
+    appendChunk(png, "IEND", std::vector<unsigned char>());
+}
+
+bool writeRawImage(const std::string &path, const unsigned char *rgba, int width, int height)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(rgba), static_cast<std::streamsize>(width) * height * 4);
+    return static_cast<bool>(file);
+}
+
+bool writePNGImage(const std::string &path, const unsigned char *rgba, int width, int height)
+{
+    std::vector<unsigned char> png;
+    encodePNGImage(rgba, width, height, png);
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(png.data()), static_cast<std::streamsize>(png.size()));
+    return static_cast<bool>(file);
+}
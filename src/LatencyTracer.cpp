@@ -0,0 +1,190 @@
+#include "LatencyTracer.h"
+#include <iomanip>
+#include <cmath>
+#include <algorithm>
+
+const char *getLatencyStageName(LatencyStage stage)
+{
+    switch (stage)
+    {
+    case LatencyStage::Queue:
+        return "queue";
+    case LatencyStage::Analysis:
+        return "analysis";
+    case LatencyStage::Delivery:
+        return "delivery";
+    case LatencyStage::Display:
+        return "display";
+    case LatencyStage::EndToEnd:
+        return "end-to-end";
+    default:
+        return "unknown";
+    }
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+int LatencyHistogram::getBucketIndex(unsigned long long nanoseconds)
+{
+    // Values below 2^subBucketBits get a bucket each, above that the top
+    // subBucketBits + 1 bits select the power of two and the step within it
+    if (nanoseconds < (1ull << subBucketBits))
+    {
+        return static_cast<int>(nanoseconds);
+    }
+    int octave = 63;
+    while (!(nanoseconds >> octave))
+    {
+        --octave;
+    }
+    int subBucket = static_cast<int>((nanoseconds >> (octave - subBucketBits)) & ((1 << subBucketBits) - 1));
+    return ((octave - subBucketBits + 1) << subBucketBits) + subBucket;
+}
+
+double LatencyHistogram::getBucketMidpoint(int index)
+{
+    if (index < (1 << subBucketBits))
+    {
+        return index;
+    }
+    int octave = (index >> subBucketBits) + subBucketBits - 1;
+    int subBucket = index & ((1 << subBucketBits) - 1);
+    double width = std::ldexp(1.0, octave - subBucketBits);
+    return std::ldexp(1.0, octave) + (subBucket + 0.5) * width;
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds duration)
+{
+    unsigned long long nanoseconds = duration.count() > 0 ? static_cast<unsigned long long>(duration.count()) : 0;
+    buckets[getBucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+
+    unsigned long long previousMax = maxNanoseconds.load(std::memory_order_relaxed);
+    while (nanoseconds > previousMax && !maxNanoseconds.compare_exchange_weak(previousMax, nanoseconds, std::memory_order_relaxed))
+    {
+    }
+}
+
+LatencyStats LatencyHistogram::getStats() const
+{
+    // Buckets are read one by one while other threads may still record, so the
+    // snapshot is approximate but its total always matches its buckets
+    unsigned long long snapshot[numBuckets];
+    unsigned long long total = 0;
+    for (int i = 0; i < numBuckets; ++i)
+    {
+        snapshot[i] = buckets[i].load(std::memory_order_relaxed);
+        total += snapshot[i];
+    }
+
+    LatencyStats stats = {total, 0.0, 0.0, maxNanoseconds.load(std::memory_order_relaxed) / 1e6};
+    if (total == 0)
+    {
+        return stats;
+    }
+
+    unsigned long long p50Rank = (total + 1) / 2;
+    unsigned long long p99Rank = total - total / 100;
+    unsigned long long seen = 0;
+    bool haveP50 = false;
+    for (int i = 0; i < numBuckets; ++i)
+    {
+        seen += snapshot[i];
+        if (!haveP50 && seen >= p50Rank)
+        {
+            stats.p50Ms = getBucketMidpoint(i) / 1e6;
+            haveP50 = true;
+        }
+        if (seen >= p99Rank)
+        {
+            stats.p99Ms = getBucketMidpoint(i) / 1e6;
+            break;
+        }
+    }
+
+    // A bucket midpoint can overshoot the largest value actually recorded
+    stats.p50Ms = std::min(stats.p50Ms, stats.maxMs);
+    stats.p99Ms = std::min(stats.p99Ms, stats.maxMs);
+    return stats;
+}
+
+void LatencyHistogram::reset()
+{
+    for (std::atomic<unsigned long long> &bucket : buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    maxNanoseconds.store(0, std::memory_order_relaxed);
+}
+
+LatencyTracer &LatencyTracer::getInstance()
+{
+    static LatencyTracer instance;
+    return instance;
+}
+
+LatencyTracer::LatencyTracer()
+{
+}
+
+LatencyTracer::~LatencyTracer()
+{
+    stopPeriodicDump();
+}
+
+void LatencyTracer::record(LatencyStage stage, Clock::time_point start, Clock::time_point end)
+{
+    if (start == Clock::time_point())
+    {
+        return;
+    }
+    histograms[static_cast<int>(stage)].record(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start));
+}
+
+LatencyStats LatencyTracer::getStats(LatencyStage stage) const
+{
+    return histograms[static_cast<int>(stage)].getStats();
+}
+
+void LatencyTracer::reset()
+{
+    for (LatencyHistogram &histogram : histograms)
+    {
+        histogram.reset();
+    }
+}
+
+void LatencyTracer::dump(std::ostream &out) const
+{
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+    for (int i = 0; i < static_cast<int>(LatencyStage::Count); ++i)
+    {
+        LatencyStats stats = histograms[i].getStats();
+        if (stats.count == 0)
+        {
+            continue;
+        }
+        out << getLatencyStageName(static_cast<LatencyStage>(i))
+            << " count=" << stats.count
+            << " p50=" << stats.p50Ms << "ms"
+            << " p99=" << stats.p99Ms << "ms"
+            << " max=" << stats.maxMs << "ms" << '\n';
+    }
+    out.flush();
+    out.flags(flags);
+}
+
+void LatencyTracer::startPeriodicDump(std::ostream &out, std::chrono::milliseconds interval)
+{
+    dumper.start([this, &out]()
+                 { dump(out); },
+                 interval);
+}
+
+void LatencyTracer::stopPeriodicDump()
+{
+    dumper.stop();
+}
@@ -0,0 +1,39 @@
+#include "PeriodicDumper.h"
+
+PeriodicDumper::PeriodicDumper()
+    : running(false)
+{
+}
+
+PeriodicDumper::~PeriodicDumper()
+{
+    stop();
+}
+
+void PeriodicDumper::start(std::function<void()> dump, std::chrono::milliseconds interval)
+{
+    stop();
+
+    running = true;
+    thread = std::thread([this, dump, interval]()
+                         {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!condition.wait_for(lock, interval, [this]()
+                                   { return !running; }))
+        {
+            dump();
+        } });
+}
+
+void PeriodicDumper::stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        running = false;
+        condition.notify_all();
+    }
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+}
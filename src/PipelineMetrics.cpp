@@ -0,0 +1,197 @@
+#include "PipelineMetrics.h"
+#include <iomanip>
+
+const char *getMetricCounterName(MetricCounter counter)
+{
+    switch (counter)
+    {
+    case MetricCounter::PacketsCaptured:
+        return "packets_captured";
+    case MetricCounter::SamplesCaptured:
+        return "samples_captured";
+    case MetricCounter::SilentPackets:
+        return "silent_packets";
+    case MetricCounter::PacketsAnalysed:
+        return "packets_analysed";
+    case MetricCounter::FramesAnalysed:
+        return "frames_analysed";
+    case MetricCounter::SpectraPublished:
+        return "spectra_published";
+    case MetricCounter::SpectraDelivered:
+        return "spectra_delivered";
+    case MetricCounter::RenderFrames:
+        return "render_frames";
+    case MetricCounter::StaleRenderFrames:
+        return "stale_render_frames";
+    default:
+        return "unknown";
+    }
+}
+
+const char *getDropReasonName(DropReason reason)
+{
+    switch (reason)
+    {
+    case DropReason::RingOverrun:
+        return "ring_overrun";
+    case DropReason::PartialFrame:
+        return "partial_frame";
+    case DropReason::Superseded:
+        return "superseded";
+    default:
+        return "unknown";
+    }
+}
+
+const char *getMetricGaugeName(MetricGauge gauge)
+{
+    switch (gauge)
+    {
+    case MetricGauge::RingFill:
+        return "ring_fill";
+    case MetricGauge::PacketTime:
+        return "packet_time_ns";
+    case MetricGauge::RenderTime:
+        return "render_time_ns";
+    default:
+        return "unknown";
+    }
+}
+
+PipelineMetrics &PipelineMetrics::getInstance()
+{
+    static PipelineMetrics instance;
+    return instance;
+}
+
+PipelineMetrics::PipelineMetrics()
+{
+    reset();
+}
+
+PipelineMetrics::~PipelineMetrics()
+{
+    stopPeriodicDump();
+}
+
+void PipelineMetrics::increment(MetricCounter counter, unsigned long long amount)
+{
+    counters[static_cast<int>(counter)].value.fetch_add(amount, std::memory_order_relaxed);
+}
+
+void PipelineMetrics::recordDrop(DropReason reason, unsigned long long amount)
+{
+    drops[static_cast<int>(reason)].value.fetch_add(amount, std::memory_order_relaxed);
+}
+
+void PipelineMetrics::recordGauge(MetricGauge gauge, long long value)
+{
+    Gauge &target = gauges[static_cast<int>(gauge)];
+    target.last.store(value, std::memory_order_relaxed);
+    target.sum.fetch_add(value, std::memory_order_relaxed);
+    target.count.fetch_add(1, std::memory_order_relaxed);
+
+    long long previousMax = target.max.load(std::memory_order_relaxed);
+    while (value > previousMax && !target.max.compare_exchange_weak(previousMax, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+unsigned long long PipelineMetrics::getCounter(MetricCounter counter) const
+{
+    return counters[static_cast<int>(counter)].value.load(std::memory_order_relaxed);
+}
+
+unsigned long long PipelineMetrics::getDropCount(DropReason reason) const
+{
+    return drops[static_cast<int>(reason)].value.load(std::memory_order_relaxed);
+}
+
+unsigned long long PipelineMetrics::getTotalDropCount() const
+{
+    unsigned long long total = 0;
+    for (const Counter &drop : drops)
+    {
+        total += drop.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+GaugeStats PipelineMetrics::getGaugeStats(MetricGauge gauge) const
+{
+    // Count and sum are read separately, a concurrent update can skew the mean by one sample
+    const Gauge &source = gauges[static_cast<int>(gauge)];
+    GaugeStats stats;
+    stats.count = source.count.load(std::memory_order_relaxed);
+    stats.last = source.last.load(std::memory_order_relaxed);
+    stats.max = source.max.load(std::memory_order_relaxed);
+    stats.mean = stats.count != 0 ? static_cast<double>(source.sum.load(std::memory_order_relaxed)) / stats.count : 0.0;
+    return stats;
+}
+
+void PipelineMetrics::reset()
+{
+    for (Counter &counter : counters)
+    {
+        counter.value.store(0, std::memory_order_relaxed);
+    }
+    for (Counter &drop : drops)
+    {
+        drop.value.store(0, std::memory_order_relaxed);
+    }
+    for (Gauge &gauge : gauges)
+    {
+        gauge.count.store(0, std::memory_order_relaxed);
+        gauge.last.store(0, std::memory_order_relaxed);
+        gauge.sum.store(0, std::memory_order_relaxed);
+        gauge.max.store(0, std::memory_order_relaxed);
+    }
+}
+
+void PipelineMetrics::dump(std::ostream &out) const
+{
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+
+    out << "counters";
+    for (int i = 0; i < static_cast<int>(MetricCounter::Count); ++i)
+    {
+        out << ' ' << getMetricCounterName(static_cast<MetricCounter>(i)) << '=' << getCounter(static_cast<MetricCounter>(i));
+    }
+    out << '\n';
+
+    out << "drops";
+    for (int i = 0; i < static_cast<int>(DropReason::Count); ++i)
+    {
+        out << ' ' << getDropReasonName(static_cast<DropReason>(i)) << '=' << getDropCount(static_cast<DropReason>(i));
+    }
+    out << '\n';
+
+    for (int i = 0; i < static_cast<int>(MetricGauge::Count); ++i)
+    {
+        GaugeStats stats = getGaugeStats(static_cast<MetricGauge>(i));
+        if (stats.count == 0)
+        {
+            continue;
+        }
+        out << getMetricGaugeName(static_cast<MetricGauge>(i))
+            << " count=" << stats.count
+            << " last=" << stats.last
+            << " mean=" << stats.mean
+            << " max=" << stats.max << '\n';
+    }
+    out.flush();
+    out.flags(flags);
+}
+
+void PipelineMetrics::startPeriodicDump(std::ostream &out, std::chrono::milliseconds interval)
+{
+    dumper.start([this, &out]()
+                 { dump(out); },
+                 interval);
+}
+
+void PipelineMetrics::stopPeriodicDump()
+{
+    dumper.stop();
+}
@@ -0,0 +1,228 @@
+#include "PolyphaseResampler.h"
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RESAMPLER_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define RESAMPLER_NEON
+#include <arm_neon.h>
+#endif
+
+// Taps per phase at unity ratio and the Kaiser shape, together about 90 dB of rejection
+static const size_t baseTapsPerPhase = 64;
+static const double kaiserBeta = 8.6;
+// Passband edge as a fraction of the lower Nyquist frequency
+static const double cutoffRatio = 0.91;
+
+// Zeroth order modified Bessel function of the first kind
+static double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; ++k)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12)
+        {
+            break;
+        }
+    }
+    return sum;
+}
+
+// count is a multiple of 4. SSE2 and NEON are part of the 64-bit baselines, so
+// unlike the FFT kernels this needs no runtime detection.
+static float dotProduct(const float *taps, const float *x, size_t count)
+{
+#if defined(RESAMPLER_SSE2)
+    // Four independent sums hide the latency of the additions
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    __m128 sum2 = _mm_setzero_ps();
+    __m128 sum3 = _mm_setzero_ps();
+    size_t k = 0;
+    for (; k + 16 <= count; k += 16)
+    {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(taps + k), _mm_loadu_ps(x + k)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(taps + k + 4), _mm_loadu_ps(x + k + 4)));
+        sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(taps + k + 8), _mm_loadu_ps(x + k + 8)));
+        sum3 = _mm_add_ps(sum3, _mm_mul_ps(_mm_loadu_ps(taps + k + 12), _mm_loadu_ps(x + k + 12)));
+    }
+    for (; k < count; k += 4)
+    {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(taps + k), _mm_loadu_ps(x + k)));
+    }
+    sum0 = _mm_add_ps(_mm_add_ps(sum0, sum1), _mm_add_ps(sum2, sum3));
+    sum0 = _mm_add_ps(sum0, _mm_movehl_ps(sum0, sum0));
+    sum0 = _mm_add_ss(sum0, _mm_shuffle_ps(sum0, sum0, 1));
+    return _mm_cvtss_f32(sum0);
+#elif defined(RESAMPLER_NEON)
+    float32x4_t sum = vdupq_n_f32(0.0f);
+    for (size_t k = 0; k < count; k += 4)
+    {
+        sum = vmlaq_f32(sum, vld1q_f32(taps + k), vld1q_f32(x + k));
+    }
+    return vaddvq_f32(sum);
+#else
+    float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+    for (size_t k = 0; k < count; k += 4)
+    {
+        sum0 += taps[k] * x[k];
+        sum1 += taps[k + 1] * x[k + 1];
+        sum2 += taps[k + 2] * x[k + 2];
+        sum3 += taps[k + 3] * x[k + 3];
+    }
+    return (sum0 + sum1) + (sum2 + sum3);
+#endif
+}
+
+PolyphaseResampler::PolyphaseResampler(unsigned int inputRate, unsigned int outputRate, unsigned int numChannels)
+    : inputRate(inputRate),
+      outputRate(outputRate),
+      numChannels(numChannels),
+      nextInput(0),
+      phase(0)
+{
+    if (inputRate == 0 || outputRate == 0 || numChannels == 0)
+    {
+        throw std::invalid_argument("Resampler rates and channel count must be positive");
+    }
+
+    unsigned int divisor = std::gcd(inputRate, outputRate);
+    up = outputRate / divisor;
+    down = inputRate / divisor;
+    inputStep = down / up;
+    phaseStep = down % up;
+    if (up > maxPhases)
+    {
+        throw std::invalid_argument("Resampling ratio needs too many filter phases");
+    }
+
+    // Downsampling narrows the passband in input samples, so the filter grows to
+    // keep the same transition width relative to it; a multiple of 4 for the dot product
+    double widening = std::max(1.0, static_cast<double>(down) / up);
+    tapsPerPhase = (static_cast<size_t>(std::ceil(baseTapsPerPhase * widening)) + 3) & ~size_t(3);
+
+    // Prototype low-pass at the upsampled rate inputRate * up
+    size_t length = tapsPerPhase * up;
+    double cutoff = cutoffRatio * 0.5 * std::min(inputRate, outputRate) / (static_cast<double>(inputRate) * up);
+    double centre = (length - 1) / 2.0;
+    double windowScale = 1.0 / besselI0(kaiserBeta);
+    std::vector<double> prototype(length);
+    for (size_t i = 0; i < length; ++i)
+    {
+        double x = i - centre;
+        double sinc = x == 0.0 ? 1.0 : std::sin(2.0 * M_PI * cutoff * x) / (2.0 * M_PI * cutoff * x);
+        double r = length > 1 ? 2.0 * x / (length - 1) : 0.0;
+        double window = besselI0(kaiserBeta * std::sqrt(std::max(0.0, 1.0 - r * r))) * windowScale;
+        prototype[i] = sinc * window;
+    }
+
+    // Split into phases, each normalized to unity gain at DC so a constant stays constant
+    phases.resize(length);
+    for (unsigned int p = 0; p < up; ++p)
+    {
+        double sum = 0.0;
+        for (size_t k = 0; k < tapsPerPhase; ++k)
+        {
+            sum += prototype[p + k * up];
+        }
+        for (size_t k = 0; k < tapsPerPhase; ++k)
+        {
+            phases[p * tapsPerPhase + (tapsPerPhase - 1 - k)] = static_cast<float>(prototype[p + k * up] / sum);
+        }
+    }
+
+    history.resize(numChannels);
+    reset();
+}
+
+unsigned int PolyphaseResampler::getInputRate() const
+{
+    return inputRate;
+}
+
+unsigned int PolyphaseResampler::getOutputRate() const
+{
+    return outputRate;
+}
+
+unsigned int PolyphaseResampler::getChannelCount() const
+{
+    return numChannels;
+}
+
+void PolyphaseResampler::reset()
+{
+    for (std::vector<float> &channel : history)
+    {
+        channel.assign(tapsPerPhase - 1, 0.0f);
+    }
+    nextInput = tapsPerPhase - 1;
+    phase = 0;
+}
+
+void PolyphaseResampler::advance(size_t &position, unsigned int &outputPhase) const
+{
+    // Steps by down / up input samples without dividing per output
+    position += inputStep;
+    outputPhase += phaseStep;
+    if (outputPhase >= up)
+    {
+        outputPhase -= up;
+        ++position;
+    }
+}
+
+void PolyphaseResampler::process(const float *interleaved, size_t numFrames, std::vector<float> &output)
+{
+    for (unsigned int channel = 0; channel < numChannels; ++channel)
+    {
+        std::vector<float> &samples = history[channel];
+        size_t offset = samples.size();
+        samples.resize(offset + numFrames);
+        for (size_t i = 0; i < numFrames; ++i)
+        {
+            samples[offset + i] = interleaved[i * numChannels + channel];
+        }
+    }
+    size_t available = history[0].size();
+
+    // Count the outputs first so the buffer is sized once
+    size_t numOutputs = 0;
+    size_t position = nextInput;
+    unsigned int outputPhase = phase;
+    while (position < available)
+    {
+        ++numOutputs;
+        advance(position, outputPhase);
+    }
+    output.resize(numOutputs * numChannels);
+
+    for (size_t t = 0; t < numOutputs; ++t)
+    {
+        const float *taps = phases.data() + phase * tapsPerPhase;
+        size_t start = nextInput + 1 - tapsPerPhase;
+        for (unsigned int channel = 0; channel < numChannels; ++channel)
+        {
+            output[t * numChannels + channel] = dotProduct(taps, history[channel].data() + start, tapsPerPhase);
+        }
+
+        advance(nextInput, phase);
+    }
+
+    // Keep the input the next output still reaches back to. When downsampling the
+    // next output can lie beyond the buffered input, the indices then keep counting
+    // from the samples still to come.
+    size_t consumed = std::min(nextInput + 1 - tapsPerPhase, available);
+    for (std::vector<float> &samples : history)
+    {
+        samples.erase(samples.begin(), samples.begin() + consumed);
+    }
+    nextInput -= consumed;
+}
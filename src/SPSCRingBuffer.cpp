@@ -0,0 +1,157 @@
+#include "SPSCRingBuffer.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+SPSCRingBuffer::SPSCRingBuffer(size_t capacity)
+    : ring(capacity),
+      capacity(capacity),
+      writePosition(0),
+      cachedReadPosition(0),
+      droppedSamples(0),
+      overruns(0),
+      readPosition(0),
+      cachedWritePosition(0),
+      consumerWaiting(false),
+      closed(false)
+{
+    if (capacity == 0)
+    {
+        throw std::invalid_argument("SPSCRingBuffer capacity must be positive");
+    }
+}
+
+size_t SPSCRingBuffer::getCapacity() const
+{
+    return capacity;
+}
+
+bool SPSCRingBuffer::write(const float *samples, size_t count)
+{
+    unsigned long long position = writePosition.load(std::memory_order_relaxed);
+    if (capacity - (position - cachedReadPosition) < count)
+    {
+        cachedReadPosition = readPosition.load(std::memory_order_acquire);
+        if (capacity - (position - cachedReadPosition) < count)
+        {
+            droppedSamples.fetch_add(count, std::memory_order_relaxed);
+            overruns.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    // At most two copies, up to the end of the ring and then from its start
+    size_t index = static_cast<size_t>(position % capacity);
+    size_t first = std::min(count, capacity - index);
+    std::memcpy(ring.data() + index, samples, first * sizeof(float));
+    std::memcpy(ring.data(), samples + first, (count - first) * sizeof(float));
+    writePosition.store(position + count, std::memory_order_release);
+
+    // Pairs with the fence in waitForData: either the consumer sees the new
+    // position or the producer sees that it went to sleep and wakes it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumerWaiting.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock(waitMutex);
+        dataAvailable.notify_one();
+    }
+    return true;
+}
+
+size_t SPSCRingBuffer::getAvailable() const
+{
+    cachedWritePosition = writePosition.load(std::memory_order_acquire);
+    return static_cast<size_t>(cachedWritePosition - readPosition.load(std::memory_order_relaxed));
+}
+
+size_t SPSCRingBuffer::read(float *samples, size_t maxCount)
+{
+    size_t count = 0;
+    while (count < maxCount)
+    {
+        const float *run = nullptr;
+        size_t length = std::min(peek(run), maxCount - count);
+        if (length == 0)
+        {
+            break;
+        }
+        std::memcpy(samples + count, run, length * sizeof(float));
+        consume(length);
+        count += length;
+    }
+    return count;
+}
+
+size_t SPSCRingBuffer::readBlocking(float *samples, size_t maxCount)
+{
+    if (!waitForData())
+    {
+        return 0;
+    }
+    return read(samples, maxCount);
+}
+
+bool SPSCRingBuffer::waitForData()
+{
+    if (getAvailable() > 0)
+    {
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock(waitMutex);
+    consumerWaiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    dataAvailable.wait(lock, [this]()
+                       { return this->getAvailable() > 0 || closed; });
+    consumerWaiting.store(false, std::memory_order_relaxed);
+    return getAvailable() > 0;
+}
+
+size_t SPSCRingBuffer::peek(const float *&samples) const
+{
+    unsigned long long position = readPosition.load(std::memory_order_relaxed);
+    if (cachedWritePosition == position)
+    {
+        cachedWritePosition = writePosition.load(std::memory_order_acquire);
+    }
+
+    size_t index = static_cast<size_t>(position % capacity);
+    samples = ring.data() + index;
+    return static_cast<size_t>(std::min<unsigned long long>(cachedWritePosition - position, capacity - index));
+}
+
+void SPSCRingBuffer::consume(size_t count)
+{
+    readPosition.store(readPosition.load(std::memory_order_relaxed) + count, std::memory_order_release);
+}
+
+void SPSCRingBuffer::close()
+{
+    closed = true;
+    std::lock_guard<std::mutex> lock(waitMutex);
+    dataAvailable.notify_all();
+}
+
+bool SPSCRingBuffer::isClosed() const
+{
+    return closed;
+}
+
+void SPSCRingBuffer::reset()
+{
+    writePosition = 0;
+    cachedReadPosition = 0;
+    readPosition = 0;
+    cachedWritePosition = 0;
+    closed = false;
+}
+
+unsigned long long SPSCRingBuffer::getDroppedSampleCount() const
+{
+    return droppedSamples.load(std::memory_order_relaxed);
+}
+
+unsigned long long SPSCRingBuffer::getOverrunCount() const
+{
+    return overruns.load(std::memory_order_relaxed);
+}
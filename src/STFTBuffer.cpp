@@ -0,0 +1,86 @@
+#include "STFTBuffer.h"
+#include <algorithm>
+#include <stdexcept>
+
+STFTBuffer::STFTBuffer(size_t windowSize, size_t hopSize)
+    : windowSize(windowSize),
+      hopSize(hopSize),
+      ring(windowSize, 0.0f),
+      writeIndex(0),
+      samplesWritten(0),
+      nextFrameEnd(windowSize)
+{
+    if (windowSize == 0 || hopSize == 0)
+    {
+        throw std::invalid_argument("STFTBuffer window and hop size must be positive");
+    }
+}
+
+size_t STFTBuffer::getWindowSize() const
+{
+    return windowSize;
+}
+
+size_t STFTBuffer::getHopSize() const
+{
+    return hopSize;
+}
+
+size_t STFTBuffer::push(const float *samples, size_t count)
+{
+    // Never write past the end of a pending frame, so the ring only has to hold one window
+    if (samplesWritten >= nextFrameEnd)
+    {
+        return 0;
+    }
+    size_t toWrite = static_cast<size_t>(std::min<unsigned long long>(count, nextFrameEnd - samplesWritten));
+
+    size_t written = 0;
+    while (written < toWrite)
+    {
+        size_t chunk = std::min(toWrite - written, windowSize - writeIndex);
+        std::copy(samples + written, samples + written + chunk, ring.begin() + writeIndex);
+        written += chunk;
+        writeIndex = (writeIndex + chunk) % windowSize;
+    }
+    samplesWritten += toWrite;
+    return toWrite;
+}
+
+bool STFTBuffer::nextFrame(std::vector<float> &frame)
+{
+    if (samplesWritten < nextFrameEnd)
+    {
+        return false;
+    }
+
+    // writeIndex points at the oldest sample once the ring is full
+    frame.resize(windowSize);
+    std::copy(ring.begin() + writeIndex, ring.end(), frame.begin());
+    std::copy(ring.begin(), ring.begin() + writeIndex, frame.begin() + (windowSize - writeIndex));
+    nextFrameEnd += hopSize;
+    return true;
+}
+
+bool STFTBuffer::nextFrame(std::vector<float> &frame, const WindowFunction &window)
+{
+    if (samplesWritten < nextFrameEnd)
+    {
+        return false;
+    }
+
+    size_t oldest = windowSize - writeIndex;
+    frame.resize(windowSize);
+    window.apply(ring.data() + writeIndex, 0, oldest, frame.data());
+    window.apply(ring.data(), oldest, writeIndex, frame.data() + oldest);
+    nextFrameEnd += hopSize;
+    return true;
+}
+
+void STFTBuffer::reset()
+{
+    std::fill(ring.begin(), ring.end(), 0.0f);
+    writeIndex = 0;
+    samplesWritten = 0;
+    nextFrameEnd = windowSize;
+}
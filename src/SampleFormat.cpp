@@ -0,0 +1,258 @@
+#include "SampleFormat.h"
+#include <cstring>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SAMPLE_KERNELS_X86
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define SAMPLE_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(SAMPLE_KERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SAMPLE_TARGET_SSE2 __attribute__((target("sse2")))
+#define SAMPLE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SAMPLE_TARGET_SSE2
+#define SAMPLE_TARGET_AVX2
+#endif
+
+static const float int16Scale = 1.0f / 32768.0f;
+static const float int24Scale = 1.0f / 8388608.0f;
+static const float int32Scale = 1.0f / 2147483648.0f;
+
+size_t getSampleFormatSize(SampleFormat format)
+{
+    switch (format)
+    {
+    case SampleFormat::Int16:
+        return 2;
+    case SampleFormat::Int24:
+        return 3;
+    case SampleFormat::Int32:
+    case SampleFormat::Float32:
+        return 4;
+    }
+    return 0;
+}
+
+const char *getSampleFormatName(SampleFormat format)
+{
+    switch (format)
+    {
+    case SampleFormat::Int16:
+        return "int16";
+    case SampleFormat::Int24:
+        return "int24";
+    case SampleFormat::Int32:
+        return "int32";
+    case SampleFormat::Float32:
+        return "float32";
+    }
+    return "unknown";
+}
+
+static void convertInt16Scalar(const unsigned char *in, size_t count, float *out)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        int16_t value = static_cast<int16_t>(in[2 * i] | (in[2 * i + 1] << 8));
+        out[i] = value * int16Scale;
+    }
+}
+
+static void convertInt24Scalar(const unsigned char *in, size_t count, float *out)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        // Assemble in the top three bytes so the sign comes along, then drop the low byte
+        uint32_t bits = (static_cast<uint32_t>(in[3 * i]) << 8) | (static_cast<uint32_t>(in[3 * i + 1]) << 16) |
+                        (static_cast<uint32_t>(in[3 * i + 2]) << 24);
+        out[i] = static_cast<float>(static_cast<int32_t>(bits) >> 8) * int24Scale;
+    }
+}
+
+static void convertInt32Scalar(const unsigned char *in, size_t count, float *out)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint32_t bits = static_cast<uint32_t>(in[4 * i]) | (static_cast<uint32_t>(in[4 * i + 1]) << 8) |
+                        (static_cast<uint32_t>(in[4 * i + 2]) << 16) | (static_cast<uint32_t>(in[4 * i + 3]) << 24);
+        out[i] = static_cast<float>(static_cast<int32_t>(bits)) * int32Scale;
+    }
+}
+
+static void convertFloat32(const unsigned char *in, size_t count, float *out)
+{
+    std::memcpy(out, in, count * sizeof(float));
+}
+
+#if defined(SAMPLE_KERNELS_X86)
+SAMPLE_TARGET_SSE2 static void convertInt16SSE2(const unsigned char *in, size_t count, float *out)
+{
+    const __m128 scale = _mm_set1_ps(int16Scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 2 * i));
+        // Interleaving with zeros puts each sample in the top half, the arithmetic shift sign-extends it
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(_mm_setzero_si128(), samples), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(_mm_setzero_si128(), samples), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+    }
+    convertInt16Scalar(in + 2 * i, count - i, out + i);
+}
+
+SAMPLE_TARGET_SSE2 static void convertInt32SSE2(const unsigned char *in, size_t count, float *out)
+{
+    const __m128 scale = _mm_set1_ps(int32Scale);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 4 * i));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(samples), scale));
+    }
+    convertInt32Scalar(in + 4 * i, count - i, out + i);
+}
+
+SAMPLE_TARGET_AVX2 static void convertInt16AVX2(const unsigned char *in, size_t count, float *out)
+{
+    const __m256 scale = _mm256_set1_ps(int16Scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 2 * i));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(samples)), scale));
+    }
+    convertInt16Scalar(in + 2 * i, count - i, out + i);
+}
+
+SAMPLE_TARGET_AVX2 static void convertInt24AVX2(const unsigned char *in, size_t count, float *out)
+{
+    // Each 128-bit lane holds four packed samples, the shuffle moves every one
+    // into the top three bytes of a 32-bit slot with a zero low byte
+    const __m256i spread = _mm256_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+                                            -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    const __m256 scale = _mm256_set1_ps(int32Scale);
+    size_t i = 0;
+    // The second load reads four bytes past the eight samples, stop while they still belong to the input
+    for (; i + 10 <= count; i += 8)
+    {
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 3 * i));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 3 * i + 12));
+        __m256i samples = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+        __m256i shifted = _mm256_shuffle_epi8(samples, spread);
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(shifted), scale));
+    }
+    convertInt24Scalar(in + 3 * i, count - i, out + i);
+}
+
+SAMPLE_TARGET_AVX2 static void convertInt32AVX2(const unsigned char *in, size_t count, float *out)
+{
+    const __m256 scale = _mm256_set1_ps(int32Scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i samples = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + 4 * i));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(samples), scale));
+    }
+    convertInt32Scalar(in + 4 * i, count - i, out + i);
+}
+#endif
+
+#if defined(SAMPLE_KERNELS_NEON)
+static void convertInt16NEON(const unsigned char *in, size_t count, float *out)
+{
+    const float32x4_t scale = vdupq_n_f32(int16Scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        int16x8_t samples = vreinterpretq_s16_u8(vld1q_u8(in + 2 * i));
+        int32x4_t low = vmovl_s16(vget_low_s16(samples));
+        int32x4_t high = vmovl_s16(vget_high_s16(samples));
+        vst1q_f32(out + i, vmulq_f32(vcvtq_f32_s32(low), scale));
+        vst1q_f32(out + i + 4, vmulq_f32(vcvtq_f32_s32(high), scale));
+    }
+    convertInt16Scalar(in + 2 * i, count - i, out + i);
+}
+
+static void convertInt32NEON(const unsigned char *in, size_t count, float *out)
+{
+    const float32x4_t scale = vdupq_n_f32(int32Scale);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        int32x4_t samples = vreinterpretq_s32_u8(vld1q_u8(in + 4 * i));
+        vst1q_f32(out + i, vmulq_f32(vcvtq_f32_s32(samples), scale));
+    }
+    convertInt32Scalar(in + 4 * i, count - i, out + i);
+}
+#endif
+
+static SampleConversionFunction getScalarConversion(SampleFormat format)
+{
+    switch (format)
+    {
+    case SampleFormat::Int16:
+        return convertInt16Scalar;
+    case SampleFormat::Int24:
+        return convertInt24Scalar;
+    case SampleFormat::Int32:
+        return convertInt32Scalar;
+    default:
+        return convertFloat32;
+    }
+}
+
+SampleConversionFunction getSampleConversion(SampleFormat format, FFTKernelType kernelType)
+{
+    if (!isFFTKernelSupported(kernelType))
+    {
+        return getScalarConversion(format);
+    }
+
+    // Float32 is a copy and 24-bit needs a byte shuffle SSE2 lacks, those stay scalar
+    switch (kernelType)
+    {
+#if defined(SAMPLE_KERNELS_X86)
+    case FFTKernelType::SSE2:
+        if (format == SampleFormat::Int16)
+            return convertInt16SSE2;
+        if (format == SampleFormat::Int32)
+            return convertInt32SSE2;
+        break;
+    case FFTKernelType::AVX2:
+        if (format == SampleFormat::Int16)
+            return convertInt16AVX2;
+        if (format == SampleFormat::Int24)
+            return convertInt24AVX2;
+        if (format == SampleFormat::Int32)
+            return convertInt32AVX2;
+        break;
+#endif
+#if defined(SAMPLE_KERNELS_NEON)
+    case FFTKernelType::NEON:
+        if (format == SampleFormat::Int16)
+            return convertInt16NEON;
+        if (format == SampleFormat::Int32)
+            return convertInt32NEON;
+        break;
+#endif
+    default:
+        break;
+    }
+    return getScalarConversion(format);
+}
+
+void convertSamples(SampleFormat format, const void *in, size_t count, float *out)
+{
+    static const SampleConversionFunction conversions[] = {
+        getSampleConversion(SampleFormat::Int16),
+        getSampleConversion(SampleFormat::Int24),
+        getSampleConversion(SampleFormat::Int32),
+        getSampleConversion(SampleFormat::Float32),
+    };
+    conversions[static_cast<int>(format)](static_cast<const unsigned char *>(in), count, out);
+}
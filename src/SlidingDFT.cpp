@@ -0,0 +1,125 @@
+#include "SlidingDFT.h"
+#include <cmath>
+#include <algorithm>
+
+// Pole radius slightly inside the unit circle so rounding errors decay instead of accumulating
+static const double damping = 0.99999;
+
+// Upper bound on samples handled per band before moving to the next band
+static const size_t chunkSize = 256;
+
+SlidingDFT::SlidingDFT(double sampleRate, unsigned int numBands, FrequencyScale scale, double lowerFrequency, double upperFrequency, size_t maxLength)
+    : bands(numBands),
+      maxChunk(chunkSize),
+      writeIndex(0)
+{
+    maxLength = std::max<size_t>(maxLength, 4);
+
+    BandLayout layout;
+    layout.configure(maxLength, sampleRate, numBands, scale, lowerFrequency, upperFrequency);
+
+    for (unsigned int i = 0; i < numBands; ++i)
+    {
+        double start = layout.getBandStartFrequency(i);
+        double end = layout.getBandEndFrequency(i);
+        double centre = scale == FrequencyScale::Linear ? (start + end) / 2.0 : std::sqrt(start * end);
+
+        // Two bins per band: the band edges sit at half amplitude on the Hann main
+        // lobe and the lobe ends at the neighbouring band centres
+        double length = 2.0 * sampleRate / std::max(end - start, 1e-3);
+        Band &band = bands[i];
+        band.length = static_cast<size_t>(std::min(std::max(length, 4.0), static_cast<double>(maxLength)));
+        maxChunk = std::min(maxChunk, band.length);
+
+        double omega = 2.0 * M_PI * centre / sampleRate;
+        double binSpacing = 2.0 * M_PI / band.length;
+        for (int r = 0; r < 3; ++r)
+        {
+            band.state[r] = std::complex<double>(0.0, 0.0);
+            band.rotation[r] = std::polar(damping, omega + (r - 1) * binSpacing);
+        }
+        // e^(i * omega * length) is the same for all three resonators
+        band.delayedRotation = std::polar(std::pow(damping, static_cast<double>(band.length)), omega * band.length);
+        band.gain = 4.0 / band.length;
+    }
+
+    // Room for the longest window plus one chunk, so writing a chunk never
+    // overwrites a sample that chunk still has to subtract
+    history.assign(maxLength + maxChunk, 0.0f);
+}
+
+unsigned int SlidingDFT::getNumBands() const
+{
+    return static_cast<unsigned int>(bands.size());
+}
+
+void SlidingDFT::process(const float *samples, size_t count)
+{
+    size_t historySize = history.size();
+    while (count > 0)
+    {
+        size_t chunk = std::min(count, maxChunk);
+        for (size_t n = 0; n < chunk; ++n)
+        {
+            history[writeIndex + n < historySize ? writeIndex + n : writeIndex + n - historySize] = samples[n];
+        }
+        processChunk(chunk);
+        writeIndex = (writeIndex + chunk) % historySize;
+        samples += chunk;
+        count -= chunk;
+    }
+}
+
+void SlidingDFT::processChunk(size_t count)
+{
+    size_t historySize = history.size();
+    for (Band &band : bands)
+    {
+        // Band outer, sample inner: the three recurrences stay in registers and overlap.
+        // Spelled out in real arithmetic, std::complex multiplication adds NaN checks.
+        double re0 = band.state[0].real(), im0 = band.state[0].imag();
+        double re1 = band.state[1].real(), im1 = band.state[1].imag();
+        double re2 = band.state[2].real(), im2 = band.state[2].imag();
+        const double rotRe0 = band.rotation[0].real(), rotIm0 = band.rotation[0].imag();
+        const double rotRe1 = band.rotation[1].real(), rotIm1 = band.rotation[1].imag();
+        const double rotRe2 = band.rotation[2].real(), rotIm2 = band.rotation[2].imag();
+        const double delayedRe = band.delayedRotation.real(), delayedIm = band.delayedRotation.imag();
+
+        size_t current = writeIndex;
+        size_t delayed = writeIndex >= band.length ? writeIndex - band.length : writeIndex + historySize - band.length;
+        for (size_t n = 0; n < count; ++n)
+        {
+            // S[n] = r e^(i w) S[n-1] + x[n] - r^N e^(i w N) x[n-N]
+            double oldest = history[delayed];
+            double inputRe = history[current] - delayedRe * oldest;
+            double inputIm = -delayedIm * oldest;
+
+            double nextRe0 = rotRe0 * re0 - rotIm0 * im0 + inputRe;
+            im0 = rotRe0 * im0 + rotIm0 * re0 + inputIm;
+            re0 = nextRe0;
+            double nextRe1 = rotRe1 * re1 - rotIm1 * im1 + inputRe;
+            im1 = rotRe1 * im1 + rotIm1 * re1 + inputIm;
+            re1 = nextRe1;
+            double nextRe2 = rotRe2 * re2 - rotIm2 * im2 + inputRe;
+            im2 = rotRe2 * im2 + rotIm2 * re2 + inputIm;
+            re2 = nextRe2;
+
+            current = current + 1 == historySize ? 0 : current + 1;
+            delayed = delayed + 1 == historySize ? 0 : delayed + 1;
+        }
+        band.state[0] = std::complex<double>(re0, im0);
+        band.state[1] = std::complex<double>(re1, im1);
+        band.state[2] = std::complex<double>(re2, im2);
+    }
+}
+
+void SlidingDFT::getMagnitudes(std::vector<float> &magnitudes) const
+{
+    magnitudes.resize(bands.size());
+    for (size_t i = 0; i < bands.size(); ++i)
+    {
+        const Band &band = bands[i];
+        std::complex<double> windowed = 0.5 * band.state[1] - 0.25 * (band.state[0] + band.state[2]);
+        magnitudes[i] = static_cast<float>(std::abs(windowed) * band.gain);
+    }
+}
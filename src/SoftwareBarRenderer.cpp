@@ -0,0 +1,118 @@
+#include "SoftwareBarRenderer.h"
+#include "ImageWriter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFTWARE_RENDERER_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SOFTWARE_RENDERER_NEON
+#include <arm_neon.h>
+#endif
+
+static uint8_t toChannel(float value)
+{
+    return static_cast<uint8_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 255.0f));
+}
+
+// The pixel with its bytes in R, G, B, A order in memory, whatever the endianness
+static uint32_t packColor(const BarColor &color)
+{
+    uint8_t bytes[4] = {toChannel(color.red), toChannel(color.green), toChannel(color.blue), toChannel(color.alpha)};
+    uint32_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+// Writes count copies of value. Bars are spans of tens to hundreds of pixels, so
+// 16 bytes per store is most of the cost of a frame; SSE2 and NEON are part of
+// the 64-bit baselines like in the resampler.
+static void fillSpan(uint32_t *span, size_t count, uint32_t value)
+{
+    size_t i = 0;
+#if defined(SOFTWARE_RENDERER_SSE2)
+    __m128i fill = _mm_set1_epi32(static_cast<int>(value));
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(span + i), fill);
+    }
+#elif defined(SOFTWARE_RENDERER_NEON)
+    uint32x4_t fill = vdupq_n_u32(value);
+    for (; i + 4 <= count; i += 4)
+    {
+        vst1q_u32(span + i, fill);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        span[i] = value;
+    }
+}
+
+SoftwareBarRenderer::SoftwareBarRenderer()
+    : width(0),
+      height(0)
+{
+}
+
+void SoftwareBarRenderer::render(const std::vector<float> &heights, int width, int height, const BarColor &color)
+{
+    this->width = std::max(width, 0);
+    this->height = std::max(height, 0);
+    pixels.resize(static_cast<size_t>(this->width) * this->height);
+    fillSpan(pixels.data(), pixels.size(), 0);
+
+    uint32_t value = packColor(color);
+    for (size_t i = 0; i < heights.size(); ++i)
+    {
+        BarRect bar = getBarRect(i, heights.size(), width, height, heights[i]);
+        fillRect(static_cast<int>(bar.left), static_cast<int>(bar.right),
+                 static_cast<int>(bar.bottom), static_cast<int>(bar.top), value);
+    }
+}
+
+// Columns [left, right) and GL rows [bottom, top), counted up from the bottom
+void SoftwareBarRenderer::fillRect(int left, int right, int bottom, int top, uint32_t value)
+{
+    left = std::max(left, 0);
+    right = std::min(right, width);
+    bottom = std::max(bottom, 0);
+    top = std::min(top, height);
+    if (left >= right || bottom >= top)
+    {
+        return;
+    }
+
+    for (int row = bottom; row < top; ++row)
+    {
+        uint32_t *line = pixels.data() + static_cast<size_t>(height - 1 - row) * width;
+        fillSpan(line + left, right - left, value);
+    }
+}
+
+int SoftwareBarRenderer::getWidth() const
+{
+    return width;
+}
+
+int SoftwareBarRenderer::getHeight() const
+{
+    return height;
+}
+
+const unsigned char *SoftwareBarRenderer::getPixels() const
+{
+    return reinterpret_cast<const unsigned char *>(pixels.data());
+}
+
+bool SoftwareBarRenderer::saveRaw(const std::string &path) const
+{
+    return writeRawImage(path, getPixels(), width, height);
+}
+
+bool SoftwareBarRenderer::savePNG(const std::string &path) const
+{
+    return writePNGImage(path, getPixels(), width, height);
+}
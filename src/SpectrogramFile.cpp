@@ -0,0 +1,514 @@
+#include "SpectrogramFile.h"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+static const char magic[4] = {'A', 'V', 'S', 'P'};
+static const uint16_t formatVersion = 1;
+static const size_t headerSize = 72;
+static const uint8_t deltaCodedFlag = 1;
+static const uint32_t defaultKeyframeInterval = 64;
+
+static void putUInt16(unsigned char *bytes, uint16_t value)
+{
+    bytes[0] = static_cast<unsigned char>(value);
+    bytes[1] = static_cast<unsigned char>(value >> 8);
+}
+
+static void putUInt32(unsigned char *bytes, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+        bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+static void putUInt64(unsigned char *bytes, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i)
+        bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+static void putFloat(unsigned char *bytes, float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    putUInt32(bytes, bits);
+}
+
+static uint16_t getUInt16(const unsigned char *bytes)
+{
+    return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+static uint32_t getUInt32(const unsigned char *bytes)
+{
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i)
+        value = (value << 8) | bytes[i];
+    return value;
+}
+
+static uint64_t getUInt64(const unsigned char *bytes)
+{
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i)
+        value = (value << 8) | bytes[i];
+    return value;
+}
+
+static float getFloat(const unsigned char *bytes)
+{
+    uint32_t bits = getUInt32(bytes);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Round to nearest even half precision, overflow saturates to infinity
+static uint16_t floatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t exponent = (bits >> 23) & 0xFF;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (exponent == 0xFF)
+        return static_cast<uint16_t>(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+
+    int halfExponent = static_cast<int>(exponent) - 127 + 15;
+    if (halfExponent >= 31)
+        return static_cast<uint16_t>(sign | 0x7C00);
+    if (halfExponent <= 0)
+    {
+        // Subnormal or zero, shift the implicit leading one into the mantissa
+        if (halfExponent < -10)
+            return static_cast<uint16_t>(sign);
+        mantissa |= 0x800000;
+        int shift = 14 - halfExponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t midpoint = 1u << (shift - 1);
+        if (remainder > midpoint || (remainder == midpoint && (half & 1)))
+            ++half;
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    uint32_t half = (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+        ++half; // A carry into the exponent is still the correctly rounded value
+    return static_cast<uint16_t>(sign | half);
+}
+
+static float halfToFloat(uint16_t half)
+{
+    uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+
+    uint32_t bits;
+    if (exponent == 0x1F)
+    {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else if (exponent != 0)
+    {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+    else if (mantissa != 0)
+    {
+        // Subnormal half, normalize it for float
+        int shift = 0;
+        while (!(mantissa & 0x400))
+        {
+            mantissa <<= 1;
+            ++shift;
+        }
+        bits = sign | (static_cast<uint32_t>(127 - 15 + 1 - shift) << 23) | ((mantissa & 0x3FF) << 13);
+    }
+    else
+    {
+        bits = sign;
+    }
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static uint32_t getQuantizationLevels(SpectrogramEncoding encoding)
+{
+    return encoding == SpectrogramEncoding::UInt8 ? 255u : 65535u;
+}
+
+static size_t getValueSize(SpectrogramEncoding encoding)
+{
+    return encoding == SpectrogramEncoding::UInt8 ? 1 : 2;
+}
+
+static void serializeHeader(const SpectrogramHeader &header, uint64_t indexOffset, unsigned char *bytes)
+{
+    std::memset(bytes, 0, headerSize);
+    std::memcpy(bytes, magic, sizeof(magic));
+    putUInt16(bytes + 4, formatVersion);
+    bytes[6] = static_cast<unsigned char>(header.encoding);
+    bytes[7] = header.deltaCoded ? deltaCodedFlag : 0;
+    putUInt32(bytes + 8, header.sampleRate);
+    putUInt32(bytes + 12, header.fftSize);
+    putUInt32(bytes + 16, header.hopSize);
+    putUInt32(bytes + 20, header.numBands);
+    putUInt32(bytes + 24, header.numStreams);
+    bytes[28] = static_cast<unsigned char>(header.frequencyScale);
+    putFloat(bytes + 32, header.lowerFrequency);
+    putFloat(bytes + 36, header.upperFrequency);
+    putFloat(bytes + 40, header.minValue);
+    putFloat(bytes + 44, header.maxValue);
+    putUInt32(bytes + 48, header.firstFrameSample);
+    putUInt32(bytes + 52, header.keyframeInterval);
+    putUInt64(bytes + 56, header.frameCount);
+    putUInt64(bytes + 64, indexOffset);
+}
+
+uint32_t SpectrogramHeader::getValuesPerFrame() const
+{
+    return numBands * numStreams;
+}
+
+SpectrogramWriter::SpectrogramWriter()
+    : file(nullptr),
+      bytesWritten(0)
+{
+}
+
+SpectrogramWriter::~SpectrogramWriter()
+{
+    close();
+}
+
+bool SpectrogramWriter::open(const std::string &path, const SpectrogramHeader &fileHeader)
+{
+    close();
+
+    header = fileHeader;
+    header.frameCount = 0;
+    if (header.encoding == SpectrogramEncoding::Float16)
+        header.deltaCoded = false;
+    if (!header.deltaCoded)
+        header.keyframeInterval = 0;
+    else if (header.keyframeInterval == 0)
+        header.keyframeInterval = defaultKeyframeInterval;
+    if (header.getValuesPerFrame() == 0 || !(header.maxValue > header.minValue))
+        return false;
+
+    file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    // Placeholder header, the frame count and index offset are filled in by close()
+    unsigned char bytes[headerSize];
+    serializeHeader(header, 0, bytes);
+    if (std::fwrite(bytes, 1, headerSize, file) != headerSize)
+    {
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+    bytesWritten = headerSize;
+
+    quantized.assign(header.getValuesPerFrame(), 0);
+    previous.assign(header.getValuesPerFrame(), 0);
+    keyframeOffsets.clear();
+    record.reserve(header.getValuesPerFrame() * 3);
+    return true;
+}
+
+bool SpectrogramWriter::writeFrame(const float *values, size_t count)
+{
+    if (!file)
+        return false;
+
+    const uint32_t levels = getQuantizationLevels(header.encoding);
+    const float scale = levels / (header.maxValue - header.minValue);
+    for (size_t i = 0; i < quantized.size(); ++i)
+    {
+        float value = i < count ? values[i] : header.minValue;
+        if (header.encoding == SpectrogramEncoding::Float16)
+        {
+            quantized[i] = floatToHalf(value);
+            continue;
+        }
+        float step = std::round((value - header.minValue) * scale);
+        quantized[i] = static_cast<uint32_t>(std::min(std::max(step, 0.0f), static_cast<float>(levels)));
+    }
+
+    record.clear();
+    bool keyframe = !header.deltaCoded || header.frameCount % header.keyframeInterval == 0;
+    if (keyframe)
+    {
+        if (header.deltaCoded)
+            keyframeOffsets.push_back(bytesWritten);
+        for (uint32_t value : quantized)
+        {
+            record.push_back(static_cast<unsigned char>(value));
+            if (header.encoding != SpectrogramEncoding::UInt8)
+                record.push_back(static_cast<unsigned char>(value >> 8));
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < quantized.size(); ++i)
+        {
+            // Zigzag maps small differences of either sign to small unsigned numbers
+            int32_t difference = static_cast<int32_t>(quantized[i]) - static_cast<int32_t>(previous[i]);
+            uint32_t zigzag = (static_cast<uint32_t>(difference) << 1) ^ static_cast<uint32_t>(difference >> 31);
+            while (zigzag >= 0x80)
+            {
+                record.push_back(static_cast<unsigned char>(zigzag | 0x80));
+                zigzag >>= 7;
+            }
+            record.push_back(static_cast<unsigned char>(zigzag));
+        }
+    }
+
+    if (std::fwrite(record.data(), 1, record.size(), file) != record.size())
+        return false;
+    bytesWritten += record.size();
+    previous.swap(quantized);
+    ++header.frameCount;
+    return true;
+}
+
+bool SpectrogramWriter::close()
+{
+    if (!file)
+        return false;
+
+    bool ok = true;
+    uint64_t indexOffset = 0;
+    if (header.deltaCoded)
+    {
+        indexOffset = bytesWritten;
+        unsigned char bytes[8];
+        for (uint64_t offset : keyframeOffsets)
+        {
+            putUInt64(bytes, offset);
+            ok = ok && std::fwrite(bytes, 1, sizeof(bytes), file) == sizeof(bytes);
+        }
+    }
+
+    unsigned char bytes[headerSize];
+    serializeHeader(header, indexOffset, bytes);
+    ok = ok && std::fseek(file, 0, SEEK_SET) == 0;
+    ok = ok && std::fwrite(bytes, 1, headerSize, file) == headerSize;
+    ok = std::fclose(file) == 0 && ok;
+    file = nullptr;
+    return ok;
+}
+
+bool SpectrogramWriter::isOpen() const
+{
+    return file != nullptr;
+}
+
+uint64_t SpectrogramWriter::getFrameCount() const
+{
+    return header.frameCount;
+}
+
+SpectrogramReader::SpectrogramReader()
+    : recordSize(0),
+      index(nullptr),
+      decodedFrame(0),
+      nextRecordOffset(0)
+{
+}
+
+bool SpectrogramReader::open(const std::string &path)
+{
+    close();
+    if (!file.open(path))
+        return false;
+
+    const unsigned char *bytes = file.getData();
+    size_t size = file.getSize();
+    if (size < headerSize || std::memcmp(bytes, magic, sizeof(magic)) != 0 || getUInt16(bytes + 4) != formatVersion || bytes[6] > static_cast<unsigned char>(SpectrogramEncoding::Float16))
+    {
+        close();
+        return false;
+    }
+
+    header.encoding = static_cast<SpectrogramEncoding>(bytes[6]);
+    header.deltaCoded = (bytes[7] & deltaCodedFlag) != 0;
+    header.sampleRate = getUInt32(bytes + 8);
+    header.fftSize = getUInt32(bytes + 12);
+    header.hopSize = getUInt32(bytes + 16);
+    header.numBands = getUInt32(bytes + 20);
+    header.numStreams = getUInt32(bytes + 24);
+    header.frequencyScale = static_cast<FrequencyScale>(bytes[28]);
+    header.lowerFrequency = getFloat(bytes + 32);
+    header.upperFrequency = getFloat(bytes + 36);
+    header.minValue = getFloat(bytes + 40);
+    header.maxValue = getFloat(bytes + 44);
+    header.firstFrameSample = getUInt32(bytes + 48);
+    header.keyframeInterval = getUInt32(bytes + 52);
+    header.frameCount = getUInt64(bytes + 56);
+    uint64_t indexOffset = getUInt64(bytes + 64);
+
+    uint64_t valuesPerFrame = static_cast<uint64_t>(header.numBands) * header.numStreams;
+    if (valuesPerFrame == 0 || valuesPerFrame > 0xFFFFFFFFull || header.sampleRate == 0)
+    {
+        close();
+        return false;
+    }
+    recordSize = static_cast<size_t>(valuesPerFrame) * getValueSize(header.encoding);
+
+    if (!header.deltaCoded)
+    {
+        // A writer that was never closed left the count at 0, take what the file holds
+        uint64_t available = (size - headerSize) / recordSize;
+        header.frameCount = header.frameCount == 0 ? available : std::min(header.frameCount, available);
+        return true;
+    }
+
+    // The writer never delta codes half floats and always has keyframes, a file
+    // that claims otherwise cannot be decoded
+    if (header.encoding == SpectrogramEncoding::Float16 || header.keyframeInterval == 0)
+    {
+        close();
+        return false;
+    }
+
+    uint64_t numKeyframes = (header.frameCount + header.keyframeInterval - 1) / header.keyframeInterval;
+    if (header.frameCount == 0)
+    {
+        return true;
+    }
+    if (indexOffset < headerSize || indexOffset > size || (size - indexOffset) / 8 < numKeyframes)
+    {
+        close();
+        return false;
+    }
+    index = bytes + indexOffset;
+    decoded.assign(static_cast<size_t>(valuesPerFrame), 0);
+    decodedFrame = header.frameCount;
+    return true;
+}
+
+void SpectrogramReader::close()
+{
+    file.close();
+    header = SpectrogramHeader();
+    recordSize = 0;
+    index = nullptr;
+    decoded.clear();
+    decodedFrame = 0;
+    nextRecordOffset = 0;
+}
+
+const SpectrogramHeader &SpectrogramReader::getHeader() const
+{
+    return header;
+}
+
+uint64_t SpectrogramReader::getFrameCount() const
+{
+    return header.frameCount;
+}
+
+double SpectrogramReader::getFrameTime(uint64_t frame) const
+{
+    return (header.firstFrameSample + static_cast<double>(frame) * header.hopSize) / header.sampleRate;
+}
+
+uint64_t SpectrogramReader::getFrameAtTime(double seconds) const
+{
+    if (header.frameCount == 0 || header.hopSize == 0)
+        return 0;
+
+    double frame = std::round((seconds * header.sampleRate - header.firstFrameSample) / header.hopSize);
+    if (frame <= 0.0)
+        return 0;
+    return std::min(static_cast<uint64_t>(frame), header.frameCount - 1);
+}
+
+bool SpectrogramReader::decodeFrom(uint64_t keyframe, uint64_t frame) const
+{
+    const unsigned char *bytes = file.getData();
+    // Delta records end where the index starts
+    size_t end = static_cast<size_t>(index - bytes);
+
+    if (keyframe != decodedFrame)
+    {
+        size_t offset = static_cast<size_t>(getUInt64(index + 8 * (keyframe / header.keyframeInterval)));
+        if (offset < headerSize || offset > end || end - offset < recordSize)
+            return false;
+        for (size_t i = 0; i < decoded.size(); ++i)
+        {
+            decoded[i] = header.encoding == SpectrogramEncoding::UInt8 ? bytes[offset + i] : getUInt16(bytes + offset + 2 * i);
+        }
+        decodedFrame = keyframe;
+        nextRecordOffset = offset + recordSize;
+    }
+
+    while (decodedFrame < frame)
+    {
+        size_t offset = nextRecordOffset;
+        for (uint32_t &value : decoded)
+        {
+            uint32_t zigzag = 0;
+            int shift = 0;
+            do
+            {
+                if (offset >= end || shift > 28)
+                {
+                    decodedFrame = header.frameCount;
+                    return false;
+                }
+                zigzag |= static_cast<uint32_t>(bytes[offset] & 0x7F) << shift;
+                shift += 7;
+            } while (bytes[offset++] & 0x80);
+
+            int32_t difference = static_cast<int32_t>(zigzag >> 1) ^ -static_cast<int32_t>(zigzag & 1);
+            value = static_cast<uint32_t>(static_cast<int32_t>(value) + difference);
+        }
+        nextRecordOffset = offset;
+        ++decodedFrame;
+    }
+    return true;
+}
+
+bool SpectrogramReader::readFrame(uint64_t frame, std::vector<float> &values) const
+{
+    if (!file.isOpen() || frame >= header.frameCount)
+        return false;
+
+    values.resize(recordSize / getValueSize(header.encoding));
+    const float step = (header.maxValue - header.minValue) / getQuantizationLevels(header.encoding);
+
+    if (!header.deltaCoded)
+    {
+        const unsigned char *record = file.getData() + headerSize + frame * recordSize;
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            if (header.encoding == SpectrogramEncoding::UInt8)
+                values[i] = header.minValue + record[i] * step;
+            else if (header.encoding == SpectrogramEncoding::UInt16)
+                values[i] = header.minValue + getUInt16(record + 2 * i) * step;
+            else
+                values[i] = halfToFloat(getUInt16(record + 2 * i));
+        }
+        return true;
+    }
+
+    // Continue from the last decoded frame when it lies between the keyframe and the target
+    uint64_t keyframe = frame - frame % header.keyframeInterval;
+    bool canContinue = decodedFrame < header.frameCount && decodedFrame >= keyframe && decodedFrame <= frame;
+    if (!decodeFrom(canContinue ? decodedFrame : keyframe, frame))
+        return false;
+
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        values[i] = header.minValue + decoded[i] * step;
+    }
+    return true;
+}
@@ -0,0 +1,94 @@
+#include "SpectrumPublisher.h"
+#include <algorithm>
+
+SpectrumPublisher::SpectrumPublisher(size_t capacity)
+    : capacity(capacity),
+      sequence(0)
+{
+    for (Slot &slot : slots)
+    {
+        slot.version = 0;
+        slot.count = 0;
+        slot.captureTime = 0;
+        slot.publishTime = 0;
+        slot.magnitudes.reset(new std::atomic<float>[capacity]);
+        for (size_t i = 0; i < capacity; ++i)
+        {
+            slot.magnitudes[i].store(0.0f, std::memory_order_relaxed);
+        }
+    }
+}
+
+size_t SpectrumPublisher::getCapacity() const
+{
+    return capacity;
+}
+
+void SpectrumPublisher::publish(const float *magnitudes, size_t count, LatencyTracer::Clock::time_point captureTime, LatencyTracer::Clock::time_point publishTime)
+{
+    unsigned long long next = sequence.load(std::memory_order_relaxed) + 1;
+    Slot &slot = slots[next % numSlots];
+    count = std::min(count, capacity);
+
+    // Mark the slot as being written before any of its fields change
+    slot.version.store(2 * next - 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.count.store(count, std::memory_order_relaxed);
+    slot.captureTime.store(captureTime.time_since_epoch().count(), std::memory_order_relaxed);
+    slot.publishTime.store(publishTime.time_since_epoch().count(), std::memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i)
+    {
+        slot.magnitudes[i].store(magnitudes[i], std::memory_order_relaxed);
+    }
+
+    slot.version.store(2 * next, std::memory_order_release);
+    sequence.store(next, std::memory_order_release);
+}
+
+bool SpectrumPublisher::read(SpectrumFrame &frame) const
+{
+    while (true)
+    {
+        unsigned long long latest = sequence.load(std::memory_order_acquire);
+        if (latest == 0)
+        {
+            return false;
+        }
+
+        const Slot &slot = slots[latest % numSlots];
+        unsigned long long version = slot.version.load(std::memory_order_acquire);
+        if (version != 2 * latest)
+        {
+            // The writer has already moved on to this slot again, start over from the newer frame
+            continue;
+        }
+
+        size_t count = slot.count.load(std::memory_order_relaxed);
+        frame.magnitudes.resize(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            frame.magnitudes[i] = slot.magnitudes[i].load(std::memory_order_relaxed);
+        }
+        LatencyTracer::Clock::rep captureTime = slot.captureTime.load(std::memory_order_relaxed);
+        LatencyTracer::Clock::rep publishTime = slot.publishTime.load(std::memory_order_relaxed);
+
+        // Pairs with the release fence in publish: if any value copied above came
+        // from a newer write, the version read below has changed too
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.version.load(std::memory_order_relaxed) != version)
+        {
+            continue;
+        }
+
+        frame.captureTime = LatencyTracer::Clock::time_point(LatencyTracer::Clock::duration(captureTime));
+        frame.publishTime = LatencyTracer::Clock::time_point(LatencyTracer::Clock::duration(publishTime));
+        frame.sequence = latest;
+        return true;
+    }
+}
+
+unsigned long long SpectrumPublisher::getSequence() const
+{
+    return sequence.load(std::memory_order_acquire);
+}
@@ -1,9 +1,13 @@
 #include "TransparentWindow.h"
+#include "PipelineMetrics.h"
 #include <iostream>
 #include <cmath>
 #include <windows.h>
 #include <shellapi.h>
 
+// Values per spectrum the window takes, longer frames are truncated
+static const size_t maxSpectrumSize = 1024;
+
 TransparentWindow::TransparentWindow() : window(nullptr),
                                          buttonEvent(0),
                                          cursorPosX(0),
@@ -11,6 +15,9 @@ TransparentWindow::TransparentWindow() : window(nullptr),
                                          offsetCursorPosX(0),
                                          offsetCursorPosY(0),
                                          oldWndProc(nullptr),
+                                         spectrumHandoff(maxSpectrumSize),
+                                         barHeightsPending(false),
+                                         renderIdle(false),
                                          hasBorder(false),
                                          running(false),
                                          settings("../settings.ini")
@@ -25,6 +32,9 @@ TransparentWindow::TransparentWindow() : window(nullptr),
     color_green = settings.getSetting<float>("color_green");
     color_blue = settings.getSetting<float>("color_blue");
     color_alpha = settings.getSetting<float>("color_alpha");
+    // Settings files from before the time constants existed keep the old smoothing
+    barSmoother = BarSmoother(settings.getSetting<float>("barAttackSeconds", BarSmoother::defaultAttackSeconds),
+                              settings.getSetting<float>("barReleaseSeconds", BarSmoother::defaultReleaseSeconds));
     renderThread = std::thread(&TransparentWindow::run, this);
 }
 
@@ -33,6 +43,7 @@ TransparentWindow::~TransparentWindow()
     if (running)
     {
         running = false;
+        glfwPostEmptyEvent();
         renderThread.join();
         unsubclassWindow();
         menu.uninitialize();
@@ -53,12 +64,20 @@ TransparentWindow::~TransparentWindow()
     settings.save("../settings.ini");
 }
 
-void TransparentWindow::setBarHeights(const std::vector<float> &heights)
+void TransparentWindow::onSpectrum(const SpectrumFrame &frame)
 {
-    barHeights = heights;
-    if (prevBarHeights.empty())
+    if (frame.magnitudes.empty())
+    {
+        return;
+    }
+    // The handoff's publish time is the delivery time, the start of the Display stage
+    spectrumHandoff.publish(frame.magnitudes.data(), frame.magnitudes.size(), frame.captureTime, LatencyTracer::Clock::now());
+    // Sequentially consistent with the idle flag, so either the render thread
+    // sees the heights before it sleeps or this sees it asleep and wakes it
+    barHeightsPending.store(true);
+    if (renderIdle.load())
     {
-        prevBarHeights = barHeights;
+        glfwPostEmptyEvent();
     }
 }
 
@@ -96,22 +115,79 @@ void TransparentWindow::run()
         cv.notify_one();
     }
 
+    LatencyTracer::Clock::time_point lastFrameTime = LatencyTracer::Clock::now();
+    int lastWidth = 0, lastHeight = 0;
     while (running)
     {
         glfwPollEvents();
+        if (glfwWindowShouldClose(window))
+        {
+            running = false;
+            break;
+        }
+
+        // With the bars at rest and no new spectrum the next frame would be the
+        // same as the last, so sleep until onSpectrum or a window event wakes
+        // the thread instead of redrawing at the refresh rate
         int display_w, display_h;
         glfwGetFramebufferSize(window, &display_w, &display_h);
-        glViewport(0, 0, display_w, display_h);
-        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        draw();
+        bool resized = display_w != lastWidth || display_h != lastHeight;
+        if (!resized && barSmoother.isSettled() && !barHeightsPending.load())
+        {
+            renderIdle.store(true);
+            if (!barHeightsPending.load() && running)
+            {
+                glfwWaitEvents();
+            }
+            renderIdle.store(false);
+            // Easing starts when the thread wakes, not at the frame before the sleep
+            lastFrameTime = LatencyTracer::Clock::now();
+            continue;
+        }
+        lastWidth = display_w;
+        lastHeight = display_h;
+
+        LatencyTracer::Clock::time_point renderStart = LatencyTracer::Clock::now();
+        float elapsedSeconds = std::chrono::duration<float>(renderStart - lastFrameTime).count();
+        lastFrameTime = renderStart;
+        PipelineMetrics &metrics = PipelineMetrics::getInstance();
+        bool showsNewHeights = false;
+        if (barHeightsPending.exchange(false))
+        {
+            // A frame published between onSpectrum's publish and its flag can be read
+            // a pass early, the late flag then finds nothing newer
+            unsigned long long previousSequence = barFrame.sequence;
+            spectrumHandoff.read(barFrame);
+            showsNewHeights = barFrame.sequence > previousSequence;
+            if (showsNewHeights)
+            {
+                metrics.increment(MetricCounter::SpectraDelivered);
+            }
+            // Spectra handed over since the last read were delivered but never shown
+            if (barFrame.sequence > previousSequence + 1)
+            {
+                metrics.recordDrop(DropReason::Superseded, barFrame.sequence - previousSequence - 1);
+            }
+        }
+        draw(elapsedSeconds);
+        metrics.recordGauge(MetricGauge::RenderTime, std::chrono::duration_cast<std::chrono::nanoseconds>(LatencyTracer::Clock::now() - renderStart).count());
         glfwSwapBuffers(window);
+        metrics.increment(MetricCounter::RenderFrames);
+        if (!showsNewHeights)
+        {
+            metrics.increment(MetricCounter::StaleRenderFrames);
+        }
 
-        if (glfwWindowShouldClose(window))
+        // With vsync the swap returns once the frame is queued for display
+        if (showsNewHeights)
         {
-            running = false;
+            LatencyTracer::Clock::time_point swapTime = LatencyTracer::Clock::now();
+            LatencyTracer::getInstance().record(LatencyStage::Display, barFrame.publishTime, swapTime);
+            LatencyTracer::getInstance().record(LatencyStage::EndToEnd, barFrame.captureTime, swapTime);
         }
     }
+    // GL objects go while the context is still current on this thread
+    barRenderer.reset();
 }
 
 void TransparentWindow::initialize()
@@ -121,18 +197,40 @@ void TransparentWindow::initialize()
     glfwWindowHint(GLFW_DECORATED, GLFW_FALSE);
     glfwWindowHint(GLFW_ALPHA_BITS, 8);
 
-    window = glfwCreateWindow(windowSizeX, windowSizeY, "Semi-Transparent Window", nullptr, nullptr);
+    // A core profile context for the instanced renderer. Where the driver has no
+    // OpenGL 3.3 or the renderer fails to set up, the window is created again with
+    // the default context and immediate mode drawing.
+    window = createContextWindow(true);
+    if (window)
+    {
+        std::unique_ptr<GLInstancedBarRenderer> instancedRenderer(new GLInstancedBarRenderer());
+        if (instancedRenderer->initialize(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)))
+        {
+            barRenderer = std::move(instancedRenderer);
+        }
+        else
+        {
+            std::cerr << "Instanced bar renderer unavailable, falling back to immediate mode" << std::endl;
+            // Its GL objects go while their context is still current
+            instancedRenderer.reset();
+            glfwDestroyWindow(window);
+            window = nullptr;
+        }
+    }
+    if (!window)
+    {
+        window = createContextWindow(false);
+        if (window)
+        {
+            barRenderer.reset(new GLBarRenderer());
+        }
+    }
     if (!window)
     {
         std::cerr << "Failed to create GLFW window" << std::endl;
         glfwTerminate();
         return;
     }
-    glfwMakeContextCurrent(window);
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-    {
-        std::cerr << "Failed to initialize GLAD" << std::endl;
-    }
     glfwSetWindowPos(window, windowPosX, windowPosY);
 
     glfwMakeContextCurrent(window);
@@ -157,9 +255,31 @@ void TransparentWindow::initialize()
     running = true;
 }
 
-void TransparentWindow::draw()
+GLFWwindow *TransparentWindow::createContextWindow(bool coreProfile)
 {
-    drawBars();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, coreProfile ? 3 : 1);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, coreProfile ? 3 : 0);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, coreProfile ? GLFW_OPENGL_CORE_PROFILE : GLFW_OPENGL_ANY_PROFILE);
+    GLFWwindow *created = glfwCreateWindow(windowSizeX, windowSizeY, "Semi-Transparent Window", nullptr, nullptr);
+    if (!created)
+    {
+        return nullptr;
+    }
+
+    glfwMakeContextCurrent(created);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        glfwMakeContextCurrent(nullptr);
+        glfwDestroyWindow(created);
+        return nullptr;
+    }
+    return created;
+}
+
+void TransparentWindow::draw(float elapsedSeconds)
+{
+    drawBars(elapsedSeconds);
 }
 
 void TransparentWindow::cursorPositionCallback(GLFWwindow *window, double xpos, double ypos)
@@ -201,63 +321,22 @@ void TransparentWindow::mouseButtonCallback(GLFWwindow *window, int button, int
     }
 }
 
-void TransparentWindow::drawBars()
+void TransparentWindow::drawBars(float elapsedSeconds)
 {
-    if (barHeights.empty())
-    {
-        return;
-    }
-
     int display_w, display_h;
     glfwGetFramebufferSize(window, &display_w, &display_h);
-    float gapWidth = 25.0f;
-    float totalGapWidth = (barHeights.size() + 1) * gapWidth;
-    float barWidth = (static_cast<float>(display_w) - totalGapWidth) / barHeights.size();
-
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    glOrtho(0, display_w, 0, display_h, -1, 1);
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-
-    float upSpeed = 0.7f;
-    float downSpeed = 0.1f;
 
-    for (size_t i = 0; i < barHeights.size(); ++i)
+    BarColor color;
+    color.red = color_red;
+    color.green = color_green;
+    color.blue = color_blue;
+    color.alpha = color_alpha;
+    // Clears even before the first spectrum arrives, the smoother starts from it
+    const std::vector<float> &targets = barFrame.magnitudes;
+    const std::vector<float> &heights = targets.empty() ? targets : barSmoother.update(targets, elapsedSeconds);
+    if (barRenderer)
     {
-        float targetHeight = barHeights[i];
-        float currentHeight = prevBarHeights[i];
-        float heightDiff = targetHeight - currentHeight;
-
-        if (heightDiff > 0)
-        {
-            currentHeight += heightDiff * upSpeed;
-        }
-        else
-        {
-            currentHeight += heightDiff * downSpeed;
-        }
-
-        float x = (i + 1) * gapWidth + i * barWidth;
-        float y = display_h / 2.0f;
-        float height = currentHeight * display_h / 2.0f;
-
-        glColor4f(color_red, color_green, color_blue, color_alpha);
-        glBegin(GL_QUADS);
-        glVertex2f(x, y);
-        glVertex2f(x + barWidth, y);
-        glVertex2f(x + barWidth, y + height);
-        glVertex2f(x, y + height);
-        glEnd();
-
-        glBegin(GL_QUADS);
-        glVertex2f(x, y);
-        glVertex2f(x + barWidth, y);
-        glVertex2f(x + barWidth, y - height);
-        glVertex2f(x, y - height);
-        glEnd();
-
-        prevBarHeights[i] = currentHeight;
+        barRenderer->render(heights, display_w, display_h, color);
     }
 }
 
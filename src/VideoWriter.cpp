@@ -0,0 +1,231 @@
+#include "VideoWriter.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+static const char y4mFrameMarker[] = "FRAME\n";
+
+bool parseVideoFormat(const std::string &name, VideoFormat &format)
+{
+    if (name == "y4m")
+        format = VideoFormat::Y4M;
+    else if (name == "rgba")
+        format = VideoFormat::RawRGBA;
+    else
+        return false;
+    return true;
+}
+
+// Colour channel scaled by alpha, the pixel as it shows over black. Rounds
+// value * alpha / 255 without a division.
+static int premultiply(int value, int alpha)
+{
+    int product = value * alpha + 128;
+    return (product + (product >> 8)) >> 8;
+}
+
+// BT.601 limited range in 8.8 fixed point
+static unsigned char toLuma(int red, int green, int blue)
+{
+    return static_cast<unsigned char>(((66 * red + 129 * green + 25 * blue + 128) >> 8) + 16);
+}
+
+static unsigned char toBlueDifference(int red, int green, int blue)
+{
+    return static_cast<unsigned char>(((-38 * red - 74 * green + 112 * blue + 128) >> 8) + 128);
+}
+
+static unsigned char toRedDifference(int red, int green, int blue)
+{
+    return static_cast<unsigned char>(((112 * red - 94 * green - 18 * blue + 128) >> 8) + 128);
+}
+
+VideoWriter::VideoWriter()
+    : file(nullptr),
+      ownsFile(false),
+      format(VideoFormat::Y4M),
+      width(0),
+      height(0),
+      frameCount(0)
+{
+}
+
+VideoWriter::~VideoWriter()
+{
+    close();
+}
+
+bool VideoWriter::open(const std::string &path, VideoFormat format, int width, int height, unsigned int fps)
+{
+    close();
+    if (width <= 0 || height <= 0 || fps == 0)
+        return false;
+
+    this->format = format;
+    this->width = width;
+    this->height = height;
+    frameCount = 0;
+    if (path == "-")
+    {
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        file = stdout;
+        ownsFile = false;
+    }
+    else
+    {
+        file = std::fopen(path.c_str(), "wb");
+        ownsFile = true;
+    }
+    if (!file)
+        return false;
+
+    if (format == VideoFormat::Y4M)
+    {
+        // Chroma samples sit between the luma samples, the JPEG and MPEG-1 siting
+        char header[128];
+        int length = std::snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%u:1 Ip A1:1 C420jpeg XYSCSS=420JPEG\n", width, height, fps);
+        if (std::fwrite(header, 1, length, file) != static_cast<size_t>(length))
+        {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t VideoWriter::getFrameSize() const
+{
+    size_t numPixels = static_cast<size_t>(width) * height;
+    if (format == VideoFormat::RawRGBA)
+        return numPixels * 4;
+
+    size_t chromaWidth = (width + 1) / 2;
+    size_t chromaHeight = (height + 1) / 2;
+    return numPixels + 2 * chromaWidth * chromaHeight;
+}
+
+void VideoWriter::encodeFrame(const unsigned char *rgba, unsigned char *encoded) const
+{
+    if (format == VideoFormat::RawRGBA)
+    {
+        std::memcpy(encoded, rgba, getFrameSize());
+        return;
+    }
+
+    size_t rowBytes = static_cast<size_t>(width) * 4;
+    size_t chromaWidth = (width + 1) / 2;
+    size_t chromaHeight = (height + 1) / 2;
+    unsigned char *lumaPlane = encoded;
+    unsigned char *bluePlane = lumaPlane + static_cast<size_t>(width) * height;
+    unsigned char *redPlane = bluePlane + chromaWidth * chromaHeight;
+
+    // Two rows at a time, one 2x2 block per chroma sample. An odd last row or
+    // column averages only the pixels inside the frame. The bar display is
+    // long runs of one colour, so a block with the same pixels as the one
+    // before it copies that block's result instead of converting again.
+    for (size_t blockY = 0; blockY < chromaHeight; ++blockY)
+    {
+        size_t top = blockY * 2;
+        size_t numRows = top + 1 < static_cast<size_t>(height) ? 2 : 1;
+        uint64_t lastPixels[2] = {};
+        unsigned char lastLuma[4] = {};
+        unsigned char lastBlue = 0, lastRed = 0;
+        bool hasLast = false;
+        for (size_t blockX = 0; blockX < chromaWidth; ++blockX)
+        {
+            size_t left = blockX * 2;
+            size_t numColumns = left + 1 < static_cast<size_t>(width) ? 2 : 1;
+            bool fullBlock = numRows == 2 && numColumns == 2;
+            unsigned char *topLuma = lumaPlane + top * width + left;
+            unsigned char *bottomLuma = topLuma + width;
+            uint64_t pixels[2] = {};
+            if (fullBlock)
+            {
+                std::memcpy(&pixels[0], rgba + top * rowBytes + left * 4, 8);
+                std::memcpy(&pixels[1], rgba + (top + 1) * rowBytes + left * 4, 8);
+                if (hasLast && pixels[0] == lastPixels[0] && pixels[1] == lastPixels[1])
+                {
+                    std::memcpy(topLuma, lastLuma, 2);
+                    std::memcpy(bottomLuma, lastLuma + 2, 2);
+                    bluePlane[blockY * chromaWidth + blockX] = lastBlue;
+                    redPlane[blockY * chromaWidth + blockX] = lastRed;
+                    continue;
+                }
+            }
+
+            int red = 0, green = 0, blue = 0;
+            for (size_t row = 0; row < numRows; ++row)
+            {
+                const unsigned char *pixel = rgba + (top + row) * rowBytes + left * 4;
+                unsigned char *luma = lumaPlane + (top + row) * width + left;
+                for (size_t column = 0; column < numColumns; ++column, pixel += 4)
+                {
+                    int alpha = pixel[3];
+                    int r = alpha == 255 ? pixel[0] : premultiply(pixel[0], alpha);
+                    int g = alpha == 255 ? pixel[1] : premultiply(pixel[1], alpha);
+                    int b = alpha == 255 ? pixel[2] : premultiply(pixel[2], alpha);
+                    luma[column] = toLuma(r, g, b);
+                    red += r;
+                    green += g;
+                    blue += b;
+                }
+            }
+            int count = static_cast<int>(numRows * numColumns);
+            red = (red + count / 2) / count;
+            green = (green + count / 2) / count;
+            blue = (blue + count / 2) / count;
+            bluePlane[blockY * chromaWidth + blockX] = toBlueDifference(red, green, blue);
+            redPlane[blockY * chromaWidth + blockX] = toRedDifference(red, green, blue);
+
+            if (fullBlock)
+            {
+                lastPixels[0] = pixels[0];
+                lastPixels[1] = pixels[1];
+                std::memcpy(lastLuma, topLuma, 2);
+                std::memcpy(lastLuma + 2, bottomLuma, 2);
+                lastBlue = bluePlane[blockY * chromaWidth + blockX];
+                lastRed = redPlane[blockY * chromaWidth + blockX];
+                hasLast = true;
+            }
+        }
+    }
+}
+
+bool VideoWriter::writeFrame(const unsigned char *encoded)
+{
+    if (!file)
+        return false;
+
+    if (format == VideoFormat::Y4M && std::fwrite(y4mFrameMarker, 1, sizeof(y4mFrameMarker) - 1, file) != sizeof(y4mFrameMarker) - 1)
+        return false;
+    size_t frameSize = getFrameSize();
+    if (std::fwrite(encoded, 1, frameSize, file) != frameSize)
+        return false;
+    ++frameCount;
+    return true;
+}
+
+bool VideoWriter::close()
+{
+    if (!file)
+        return false;
+
+    bool ok = ownsFile ? std::fclose(file) == 0 : std::fflush(file) == 0;
+    file = nullptr;
+    return ok;
+}
+
+bool VideoWriter::isOpen() const
+{
+    return file != nullptr;
+}
+
+uint64_t VideoWriter::getFrameCount() const
+{
+    return frameCount;
+}
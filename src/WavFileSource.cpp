@@ -0,0 +1,202 @@
+#include "WavFileSource.h"
+#include <cstring>
+#include <cstdint>
+#include <thread>
+#include <algorithm>
+
+static const uint16_t formatPCM = 1;
+static const uint16_t formatFloat = 3;
+static const uint16_t formatExtensible = 0xFFFE;
+
+// RIFF fields are little-endian and not necessarily aligned
+static uint16_t readUInt16(const unsigned char *bytes)
+{
+    return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+static uint32_t readUInt32(const unsigned char *bytes)
+{
+    return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+           (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+static bool parseSampleFormat(uint16_t formatTag, uint16_t bitsPerSample, SampleFormat &format)
+{
+    if (formatTag == formatFloat && bitsPerSample == 32)
+        format = SampleFormat::Float32;
+    else if (formatTag == formatPCM && bitsPerSample == 16)
+        format = SampleFormat::Int16;
+    else if (formatTag == formatPCM && bitsPerSample == 24)
+        format = SampleFormat::Int24;
+    else if (formatTag == formatPCM && bitsPerSample == 32)
+        format = SampleFormat::Int32;
+    else
+        return false;
+    return true;
+}
+
+WavFileSource::WavFileSource(const std::string &path, ReplayPacing pacing, size_t framesPerPacket)
+    : path(path),
+      pacing(pacing),
+      framesPerPacket(std::max<size_t>(framesPerPacket, 1)),
+      sampleData(nullptr),
+      frameCount(0),
+      sampleRate(0),
+      channelCount(0),
+      sampleFormat(SampleFormat::Float32),
+      isCapturing(false),
+      position(0)
+{
+}
+
+bool WavFileSource::initialize()
+{
+    if (!file.open(path))
+        return false;
+
+    if (!parseHeader())
+    {
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+bool WavFileSource::parseHeader()
+{
+    const unsigned char *bytes = file.getData();
+    size_t size = file.getSize();
+    if (size < 12 || std::memcmp(bytes, "RIFF", 4) != 0 || std::memcmp(bytes + 8, "WAVE", 4) != 0)
+        return false;
+
+    bool haveFormat = false;
+    uint16_t formatTag = 0;
+    uint16_t bitsPerSample = 0;
+    size_t offset = 12;
+    while (offset + 8 <= size)
+    {
+        const unsigned char *chunk = bytes + offset;
+        size_t chunkSize = readUInt32(chunk + 4);
+        size_t bodyOffset = offset + 8;
+        size_t available = size - bodyOffset;
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0)
+        {
+            if (chunkSize < 16 || chunkSize > available)
+                return false;
+
+            const unsigned char *format = bytes + bodyOffset;
+            formatTag = readUInt16(format);
+            bitsPerSample = readUInt16(format + 14);
+            channelCount = readUInt16(format + 2);
+            sampleRate = readUInt32(format + 4);
+            // WAVE_FORMAT_EXTENSIBLE keeps the real format tag at the start of the sub-format GUID
+            if (formatTag == formatExtensible && chunkSize >= 40)
+            {
+                formatTag = readUInt16(format + 24);
+            }
+            haveFormat = true;
+        }
+        else if (std::memcmp(chunk, "data", 4) == 0)
+        {
+            if (!haveFormat)
+                return false;
+
+            // Streaming writers leave the size open, take whatever the file holds
+            chunkSize = std::min(chunkSize, available);
+            sampleData = bytes + bodyOffset;
+
+            if (!parseSampleFormat(formatTag, bitsPerSample, sampleFormat) || channelCount == 0 || sampleRate == 0)
+                return false;
+
+            frameCount = chunkSize / (channelCount * getSampleFormatSize(sampleFormat));
+            return true;
+        }
+
+        // Chunks are padded to an even size
+        offset = bodyOffset + chunkSize + (chunkSize & 1);
+    }
+    return false;
+}
+
+void WavFileSource::startCapture()
+{
+    if (isCapturing || !file.isOpen())
+        return;
+
+    position = 0;
+    startTime = std::chrono::steady_clock::now();
+    isCapturing = true;
+}
+
+void WavFileSource::stopCapture()
+{
+    isCapturing = false;
+}
+
+float WavFileSource::getSampleRate() const
+{
+    return static_cast<float>(sampleRate);
+}
+
+unsigned int WavFileSource::getChannelCount() const
+{
+    return channelCount;
+}
+
+size_t WavFileSource::getFrameCount() const
+{
+    return frameCount;
+}
+
+std::chrono::steady_clock::time_point WavFileSource::getPacketTime() const
+{
+    // A live capture delivers a packet once its last sample has been played
+    size_t numFrames = std::min(framesPerPacket, frameCount - position);
+    std::chrono::duration<double> packetEnd((position + numFrames) / static_cast<double>(sampleRate));
+    return startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(packetEnd);
+}
+
+bool WavFileSource::acquireBuffer(const float *&samples, size_t &numSamples, std::chrono::steady_clock::time_point &captureTime)
+{
+    if (pacing == ReplayPacing::RealTime && isCapturing && position < frameCount)
+    {
+        std::this_thread::sleep_until(getPacketTime());
+    }
+    return tryAcquireBuffer(samples, numSamples, captureTime) == AcquireResult::Packet;
+}
+
+AcquireResult WavFileSource::tryAcquireBuffer(const float *&samples, size_t &numSamples, std::chrono::steady_clock::time_point &captureTime)
+{
+    samples = nullptr;
+    numSamples = 0;
+    if (!isCapturing || position >= frameCount)
+        return AcquireResult::Ended;
+
+    if (pacing == ReplayPacing::RealTime)
+    {
+        captureTime = getPacketTime();
+        if (std::chrono::steady_clock::now() < captureTime)
+            return AcquireResult::NotReady;
+    }
+    else
+    {
+        captureTime = std::chrono::steady_clock::now();
+    }
+
+    size_t numFrames = std::min(framesPerPacket, frameCount - position);
+    size_t first = position * channelCount;
+    numSamples = numFrames * channelCount;
+    position += numFrames;
+
+    if (sampleFormat == SampleFormat::Float32 && reinterpret_cast<uintptr_t>(sampleData) % alignof(float) == 0)
+    {
+        samples = reinterpret_cast<const float *>(sampleData) + first;
+        return AcquireResult::Packet;
+    }
+
+    convertedBuffer.resize(numSamples);
+    convertSamples(sampleFormat, sampleData + first * getSampleFormatSize(sampleFormat), numSamples, convertedBuffer.data());
+    samples = convertedBuffer.data();
+    return AcquireResult::Packet;
+}
@@ -0,0 +1,125 @@
+#include "WindowFunction.h"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WINDOW_FUNCTION_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define WINDOW_FUNCTION_NEON
+#include <arm_neon.h>
+#endif
+
+// Zeroth order modified Bessel function of the first kind, by its power series
+static double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    double halfX = x / 2.0;
+    for (int k = 1; k < 50; ++k)
+    {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+        if (term < sum * 1e-12)
+        {
+            break;
+        }
+    }
+    return sum;
+}
+
+WindowType parseWindowType(const std::string &name)
+{
+    if (name == "rectangular")
+        return WindowType::Rectangular;
+    if (name == "hamming")
+        return WindowType::Hamming;
+    if (name == "blackmanharris")
+        return WindowType::BlackmanHarris;
+    if (name == "flattop")
+        return WindowType::FlatTop;
+    if (name == "kaiser")
+        return WindowType::Kaiser;
+    return WindowType::Hann;
+}
+
+WindowFunction::WindowFunction(WindowType type, size_t size, double kaiserBeta)
+    : type(type),
+      table(size, 1.0f)
+{
+    std::vector<double> values(size, 1.0);
+    for (size_t n = 0; n < size; ++n)
+    {
+        double phase = 2.0 * M_PI * n / size;
+        switch (type)
+        {
+        case WindowType::Rectangular:
+            break;
+        case WindowType::Hann:
+            values[n] = 0.5 - 0.5 * std::cos(phase);
+            break;
+        case WindowType::Hamming:
+            values[n] = 0.54 - 0.46 * std::cos(phase);
+            break;
+        case WindowType::BlackmanHarris:
+            values[n] = 0.35875 - 0.48829 * std::cos(phase) + 0.14128 * std::cos(2 * phase) - 0.01168 * std::cos(3 * phase);
+            break;
+        case WindowType::FlatTop:
+            values[n] = 0.21557895 - 0.41663158 * std::cos(phase) + 0.277263158 * std::cos(2 * phase) -
+                        0.083578947 * std::cos(3 * phase) + 0.006947368 * std::cos(4 * phase);
+            break;
+        case WindowType::Kaiser:
+        {
+            double ratio = 2.0 * n / size - 1.0;
+            values[n] = besselI0(kaiserBeta * std::sqrt(1.0 - ratio * ratio)) / besselI0(kaiserBeta);
+            break;
+        }
+        }
+    }
+
+    double sum = 0.0;
+    for (double value : values)
+    {
+        sum += value;
+    }
+    double gain = sum > 0.0 ? size / sum : 1.0;
+    for (size_t n = 0; n < size; ++n)
+    {
+        table[n] = static_cast<float>(values[n] * gain);
+    }
+}
+
+WindowType WindowFunction::getType() const
+{
+    return type;
+}
+
+size_t WindowFunction::getSize() const
+{
+    return table.size();
+}
+
+const std::vector<float> &WindowFunction::getTable() const
+{
+    return table;
+}
+
+void WindowFunction::apply(const float *samples, size_t offset, size_t count, float *out) const
+{
+    const float *window = table.data() + offset;
+    size_t i = 0;
+#if defined(WINDOW_FUNCTION_SSE2)
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(samples + i), _mm_loadu_ps(window + i)));
+    }
+#elif defined(WINDOW_FUNCTION_NEON)
+    for (; i + 4 <= count; i += 4)
+    {
+        vst1q_f32(out + i, vmulq_f32(vld1q_f32(samples + i), vld1q_f32(window + i)));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        out[i] = samples[i] * window[i];
+    }
+}
@@ -0,0 +1,153 @@
+#include "WorkStealingPool.h"
+#include <algorithm>
+
+// Worker the calling thread belongs to, so nested submits stay local
+static thread_local const WorkStealingPool *currentPool = nullptr;
+static thread_local size_t currentWorker = 0;
+
+WorkStealingPool::WorkStealingPool(size_t numThreads)
+    : nextWorker(0),
+      queuedTasks(0),
+      pendingTasks(0),
+      sleepingWorkers(0),
+      stopping(false)
+{
+    if (numThreads == 0)
+    {
+        numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    for (size_t i = 0; i < numThreads; ++i)
+    {
+        workers.emplace_back(new Worker());
+    }
+    for (size_t i = 0; i < numThreads; ++i)
+    {
+        threads.emplace_back(&WorkStealingPool::run, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    waitIdle();
+    {
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        stopping = true;
+        workAvailable.notify_all();
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+size_t WorkStealingPool::getThreadCount() const
+{
+    return threads.size();
+}
+
+void WorkStealingPool::submit(Task task)
+{
+    push(std::move(task), false);
+}
+
+void WorkStealingPool::yield(Task task)
+{
+    push(std::move(task), true);
+}
+
+void WorkStealingPool::push(Task task, bool behindQueued)
+{
+    size_t index = currentPool == this ? currentWorker : nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+
+    // Counted before the push so a worker never takes a task that is not counted yet
+    pendingTasks.fetch_add(1);
+    queuedTasks.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(workers[index]->mutex);
+        // The owner pops from the back, so the front is the last it gets to
+        if (behindQueued && currentPool == this)
+            workers[index]->tasks.push_front(std::move(task));
+        else
+            workers[index]->tasks.push_back(std::move(task));
+    }
+
+    // Sequentially consistent against the sleeping worker's increment and its
+    // check of queuedTasks, so one of the two always sees the other
+    if (sleepingWorkers.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        workAvailable.notify_one();
+    }
+}
+
+void WorkStealingPool::waitIdle()
+{
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    allDone.wait(lock, [this]()
+                 { return pendingTasks.load() == 0; });
+}
+
+bool WorkStealingPool::popLocal(size_t index, Task &task)
+{
+    Worker &worker = *workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty())
+    {
+        return false;
+    }
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(size_t thief, Task &task)
+{
+    for (size_t offset = 1; offset < workers.size(); ++offset)
+    {
+        Worker &victim = *workers[(thief + offset) % workers.size()];
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || victim.tasks.empty())
+        {
+            continue;
+        }
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::run(size_t index)
+{
+    currentPool = this;
+    currentWorker = index;
+
+    Task task;
+    while (true)
+    {
+        if (popLocal(index, task) || steal(index, task))
+        {
+            queuedTasks.fetch_sub(1);
+            task();
+            task = nullptr;
+            if (pendingTasks.fetch_sub(1) == 1)
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                allDone.notify_all();
+            }
+            continue;
+        }
+
+        // A failed try_lock can skip a queued task, so only sleep when nothing is queued at all
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepingWorkers.fetch_add(1);
+        workAvailable.wait(lock, [this]()
+                           { return queuedTasks.load() > 0 || stopping; });
+        sleepingWorkers.fetch_sub(1);
+        if (stopping && queuedTasks.load() == 0)
+        {
+            return;
+        }
+    }
+}
@@ -4,12 +4,16 @@
 #include "AudioCapture.h"
 #include "AudioProcessor.h"
 #include "TransparentWindow.h"
+#include "INIFileParser.h"
+#include "LatencyTracer.h"
+#include "PipelineMetrics.h"
 
 #include <iostream>
 #include <thread>
 #include <chrono>
 #include <vector>
 #include <cmath>
+#include <fstream>
 
 int main()
 {
@@ -24,31 +28,66 @@ int main()
 
     audioCapture.startCapture();
 
+    INIFileParser settings("../settings.ini");
+    AnalysisSettings analysisSettings;
+    unsigned int fftSize = settings.getSetting<unsigned int>("fftSize");
+    unsigned int hopSize = settings.getSetting<unsigned int>("hopSize");
+    if (fftSize != 0)
+    {
+        analysisSettings.windowSize = fftSize;
+        analysisSettings.hopSize = fftSize / 4;
+    }
+    if (hopSize != 0)
+    {
+        analysisSettings.hopSize = hopSize;
+    }
+    analysisSettings.windowType = parseWindowType(settings.getSetting<std::string>("windowFunction"));
+    analysisSettings.frequencyScale = parseFrequencyScale(settings.getSetting<std::string>("frequencyScale"));
+    analysisSettings.mode = parseAnalysisMode(settings.getSetting<std::string>("analysisMode"));
+    analysisSettings.channelMode = parseChannelMode(settings.getSetting<std::string>("channelMode"));
+    // Resampling to one rate keeps the analysis the same on 44.1, 48 and 96 kHz devices
+    analysisSettings.analysisSampleRate = settings.getSetting<unsigned int>("analysisSampleRate");
+
+    // Periodically append per-stage latency percentiles to a log, 0 disables it
+    unsigned int latencyDumpSeconds = settings.getSetting<unsigned int>("latencyDumpSeconds");
+    std::ofstream latencyLog;
+    if (latencyDumpSeconds != 0)
+    {
+        latencyLog.open("../latency.log", std::ios::app);
+        LatencyTracer::getInstance().startPeriodicDump(latencyLog, std::chrono::seconds(latencyDumpSeconds));
+    }
+
+    // Periodically append the packet, frame and drop counters to a log, 0 disables it
+    unsigned int metricsDumpSeconds = settings.getSetting<unsigned int>("metricsDumpSeconds");
+    std::ofstream metricsLog;
+    if (metricsDumpSeconds != 0)
+    {
+        metricsLog.open("../metrics.log", std::ios::app);
+        PipelineMetrics::getInstance().startPeriodicDump(metricsLog, std::chrono::seconds(metricsDumpSeconds));
+    }
+
     unsigned int numberOfWindows = 12;
-    AudioProcessor audioProcessor(numberOfWindows, audioCapture);
+    AudioProcessor audioProcessor(numberOfWindows, audioCapture, analysisSettings);
     audioProcessor.startProcessing();
 
     if (!glfwInit())
     {
         std::cerr << "Failed to initialize GLFW" << std::endl;
+        LatencyTracer::getInstance().stopPeriodicDump();
+        PipelineMetrics::getInstance().stopPeriodicDump();
         return -1;
     }
 
     TransparentWindow transparentWindow;
     transparentWindow.waitUntilTransparentWindowIsRunning();
 
-    while (transparentWindow.isRunning())
-    {
-        audioProcessor.waitUntilReady();
-        std::vector<float> frequencyWindowMagnitudes = audioProcessor.getFrequencyWindowMagnitudes();
-        if (!frequencyWindowMagnitudes.empty())
-        {
-            transparentWindow.setBarHeights(frequencyWindowMagnitudes);
-        }
-    }
-
+    // Spectra go straight from the processing thread to the window's render thread
+    audioProcessor.subscribe(transparentWindow);
     transparentWindow.waitForClose();
+    audioProcessor.unsubscribe(transparentWindow);
     glfwTerminate();
+    LatencyTracer::getInstance().stopPeriodicDump();
+    PipelineMetrics::getInstance().stopPeriodicDump();
 
     std::cout << "Window closed successfully. Exiting..." << std::endl;
 
@@ -0,0 +1,95 @@
+// Checks every float32 FFT kernel the running CPU supports against the scalar
+// double precision reference fft() and rfft() for power of 2 sizes up to 65536.
+// Exits non-zero when any kernel is off by more than the tolerance.
+
+#include "FFT.h"
+
+#include <iostream>
+#include <vector>
+#include <complex>
+#include <random>
+#include <algorithm>
+#include <cmath>
+
+// Largest error allowed, relative to the largest reference magnitude
+static const double tolerance = 1e-5;
+
+static const size_t maxSize = 65536;
+
+static double relativeError(const std::vector<std::complex<double>> &reference, const std::vector<std::complex<float>> &result)
+{
+    double peak = 0.0;
+    double error = 0.0;
+    for (size_t i = 0; i < reference.size(); ++i)
+    {
+        peak = std::max(peak, std::abs(reference[i]));
+        error = std::max(error, std::abs(reference[i] - std::complex<double>(result[i])));
+    }
+    return peak > 0.0 ? error / peak : error;
+}
+
+int main()
+{
+    const FFTKernelType kernelTypes[] = {FFTKernelType::Scalar, FFTKernelType::SSE2, FFTKernelType::AVX2, FFTKernelType::NEON};
+
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+    int failures = 0;
+    for (FFTKernelType kernelType : kernelTypes)
+    {
+        if (!isFFTKernelSupported(kernelType))
+        {
+            // A plan asked for it runs the scalar kernel and has to say so
+            if (FFTPlan(16, kernelType).getKernelType() != FFTKernelType::Scalar)
+            {
+                std::cout << getFFTKernelName(kernelType) << ": unsupported plan does not report scalar" << std::endl;
+                ++failures;
+            }
+            std::cout << getFFTKernelName(kernelType) << ": not supported, skipped" << std::endl;
+            continue;
+        }
+
+        double worstComplex = 0.0;
+        double worstReal = 0.0;
+        for (size_t size = 1; size <= maxSize; size *= 2)
+        {
+            std::vector<std::complex<float>> input(size);
+            std::vector<std::complex<double>> referenceInput(size);
+            std::vector<float> realInput(size);
+            std::vector<std::complex<double>> realReferenceInput(size);
+            for (size_t i = 0; i < size; ++i)
+            {
+                input[i] = std::complex<float>(distribution(generator), distribution(generator));
+                referenceInput[i] = std::complex<double>(input[i]);
+                realInput[i] = input[i].real();
+                realReferenceInput[i] = realInput[i];
+            }
+
+            FFTPlan plan(size, kernelType);
+            std::vector<std::complex<float>> output;
+            plan.execute(input, output);
+            double complexError = relativeError(fft(referenceInput), output);
+
+            std::vector<std::complex<float>> realOutput;
+            plan.executeReal(realInput, realOutput);
+            // The full complex transform of the real samples, rfft has no size 1
+            std::vector<std::complex<double>> realReference = fft(realReferenceInput);
+            realReference.resize(size / 2 + 1);
+            double realError = relativeError(realReference, realOutput);
+
+            if (complexError > tolerance || realError > tolerance || output.size() != size || realOutput.size() != size / 2 + 1)
+            {
+                std::cout << getFFTKernelName(kernelType) << ": size " << size << " off by " << complexError
+                          << " complex, " << realError << " real" << std::endl;
+                ++failures;
+            }
+            worstComplex = std::max(worstComplex, complexError);
+            worstReal = std::max(worstReal, realError);
+        }
+        std::cout << getFFTKernelName(kernelType) << ": worst relative error " << worstComplex << " complex, "
+                  << worstReal << " real" << std::endl;
+    }
+
+    return failures == 0 ? 0 : 1;
+}
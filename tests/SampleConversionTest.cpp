@@ -0,0 +1,136 @@
+// Checks every SIMD sample conversion kernel the running CPU supports against
+// the scalar one bit for bit, and the resampler's output for random packet
+// splits against one call over the whole input. Exits non-zero on any mismatch.
+
+#include "SampleFormat.h"
+#include "PolyphaseResampler.h"
+
+#include <iostream>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+// Longer than any SIMD kernel's block, so every count from 0 covers the vector
+// loop bounds and each tail length
+static const size_t maxCount = 40;
+static const unsigned int numChannels = 2;
+
+// Output past count must stay untouched
+static const float guardValue = 12345.0f;
+
+static int checkConversions(std::mt19937 &generator)
+{
+    const FFTKernelType kernelTypes[] = {FFTKernelType::SSE2, FFTKernelType::AVX2, FFTKernelType::NEON};
+    const SampleFormat formats[] = {SampleFormat::Int16, SampleFormat::Int24, SampleFormat::Int32, SampleFormat::Float32};
+    std::uniform_int_distribution<int> byteDistribution(0, 255);
+    std::uniform_real_distribution<float> floatDistribution(-1.0f, 1.0f);
+
+    int failures = 0;
+    for (FFTKernelType kernelType : kernelTypes)
+    {
+        if (!isFFTKernelSupported(kernelType))
+        {
+            std::cout << getFFTKernelName(kernelType) << ": not supported, skipped" << std::endl;
+            continue;
+        }
+
+        int kernelFailures = 0;
+        for (SampleFormat format : formats)
+        {
+            SampleConversionFunction scalar = getSampleConversion(format, FFTKernelType::Scalar);
+            SampleConversionFunction kernel = getSampleConversion(format, kernelType);
+            size_t sampleSize = getSampleFormatSize(format);
+
+            for (size_t count = 0; count <= maxCount; ++count)
+            {
+                // One byte in, so the kernels see unaligned input. The buffer ends
+                // with the last sample, a sanitizer build reports any read past it.
+                std::vector<unsigned char> input(1 + count * sampleSize);
+                if (format == SampleFormat::Float32)
+                {
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        float sample = floatDistribution(generator);
+                        std::memcpy(&input[1 + i * sampleSize], &sample, sizeof(sample));
+                    }
+                }
+                else
+                {
+                    for (unsigned char &byte : input)
+                    {
+                        byte = static_cast<unsigned char>(byteDistribution(generator));
+                    }
+                }
+
+                std::vector<float> expected(count + 1, guardValue);
+                std::vector<float> actual(count + 1, guardValue);
+                scalar(input.data() + 1, count, expected.data());
+                kernel(input.data() + 1, count, actual.data());
+
+                if (std::memcmp(expected.data(), actual.data(), expected.size() * sizeof(float)) != 0)
+                {
+                    std::cout << getFFTKernelName(kernelType) << ": " << getSampleFormatName(format)
+                              << " differs from scalar at count " << count << std::endl;
+                    ++kernelFailures;
+                }
+            }
+        }
+        if (kernelFailures == 0)
+        {
+            std::cout << getFFTKernelName(kernelType) << ": conversions match scalar" << std::endl;
+        }
+        failures += kernelFailures;
+    }
+    return failures;
+}
+
+static int checkResampler(std::mt19937 &generator, unsigned int inputRate, unsigned int outputRate)
+{
+    // A few seconds of noise, so the phase walk wraps many times
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    size_t numFrames = 3 * inputRate;
+    std::vector<float> input(numFrames * numChannels);
+    for (float &sample : input)
+    {
+        sample = distribution(generator);
+    }
+
+    PolyphaseResampler whole(inputRate, outputRate, numChannels);
+    std::vector<float> expected;
+    whole.process(input.data(), numFrames, expected);
+
+    // Packets from empty to larger than the filter, like a capture client delivers
+    PolyphaseResampler split(inputRate, outputRate, numChannels);
+    std::uniform_int_distribution<size_t> packetDistribution(0, 1200);
+    std::vector<float> actual;
+    std::vector<float> packetOutput;
+    size_t offset = 0;
+    while (offset < numFrames)
+    {
+        size_t packetFrames = std::min(packetDistribution(generator), numFrames - offset);
+        split.process(input.data() + offset * numChannels, packetFrames, packetOutput);
+        actual.insert(actual.end(), packetOutput.begin(), packetOutput.end());
+        offset += packetFrames;
+    }
+
+    if (expected.size() != actual.size() ||
+        std::memcmp(expected.data(), actual.data(), expected.size() * sizeof(float)) != 0)
+    {
+        std::cout << "resampler " << inputRate << " -> " << outputRate << ": split packets give "
+                  << actual.size() << " samples differing from one call's " << expected.size() << std::endl;
+        return 1;
+    }
+    std::cout << "resampler " << inputRate << " -> " << outputRate << ": split packets match one call" << std::endl;
+    return 0;
+}
+
+int main()
+{
+    std::mt19937 generator(1234);
+
+    int failures = checkConversions(generator);
+    failures += checkResampler(generator, 44100, 48000);
+    failures += checkResampler(generator, 96000, 48000);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,297 @@
+// Writes spectrogram files in every encoding, with and without delta coding, and
+// reads the frames back in random order. Every value must come back within half
+// a quantization step, frame times must map back to their frames, and a file
+// whose writer never closed it must still be readable when it is not delta
+// coded. Exits non-zero on any failure.
+
+#include "SpectrogramFile.h"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <random>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+static const uint64_t numFrames = 300;
+
+// Slack for the float arithmetic of quantizing and dequantizing, far below the
+// 16-bit step
+static const float roundingSlack = 1e-6f;
+
+struct FileCase
+{
+    SpectrogramEncoding encoding;
+    bool deltaCoded;
+    uint32_t keyframeInterval;
+};
+
+static const char *getEncodingName(SpectrogramEncoding encoding)
+{
+    switch (encoding)
+    {
+    case SpectrogramEncoding::UInt8:
+        return "u8";
+    case SpectrogramEncoding::UInt16:
+        return "u16";
+    default:
+        return "f16";
+    }
+}
+
+static SpectrogramHeader makeHeader(const FileCase &fileCase)
+{
+    SpectrogramHeader header;
+    header.sampleRate = 48000;
+    header.fftSize = 2048;
+    header.hopSize = 512;
+    header.numBands = 12;
+    header.numStreams = 2;
+    header.lowerFrequency = 20.0f;
+    header.upperFrequency = 20000.0f;
+    header.encoding = fileCase.encoding;
+    header.deltaCoded = fileCase.deltaCoded;
+    header.firstFrameSample = 2048;
+    header.keyframeInterval = fileCase.keyframeInterval;
+    return header;
+}
+
+// Largest error a value may come back with
+static float getTolerance(const SpectrogramHeader &header, float value)
+{
+    if (header.encoding == SpectrogramEncoding::Float16)
+    {
+        // Half a unit in the last place of an 11-bit significand, or of the
+        // smallest subnormal
+        return std::max(std::fabs(value) * std::ldexp(1.0f, -11), std::ldexp(1.0f, -25));
+    }
+    float levels = header.encoding == SpectrogramEncoding::UInt8 ? 255.0f : 65535.0f;
+    return (header.maxValue - header.minValue) / levels / 2.0f + roundingSlack;
+}
+
+// A slowly changing spectrum with jumps across the whole range, so the deltas
+// take both signs and every varint length. The first frames hold the range ends.
+static std::vector<std::vector<float>> makeFrames(std::mt19937 &generator, const SpectrogramHeader &header)
+{
+    std::uniform_real_distribution<float> valueDistribution(header.minValue, header.maxValue);
+    std::uniform_real_distribution<float> driftDistribution(-0.01f, 0.01f);
+    std::uniform_int_distribution<int> jumpDistribution(0, 9);
+
+    std::vector<std::vector<float>> frames(numFrames, std::vector<float>(header.getValuesPerFrame()));
+    for (uint64_t frame = 0; frame < numFrames; ++frame)
+    {
+        for (size_t i = 0; i < frames[frame].size(); ++i)
+        {
+            float value;
+            if (frame == 0)
+                value = header.minValue;
+            else if (frame == 1)
+                value = header.maxValue;
+            else if (frame == 2 || jumpDistribution(generator) == 0)
+                value = valueDistribution(generator);
+            else
+                value = std::min(std::max(frames[frame - 1][i] + driftDistribution(generator), header.minValue), header.maxValue);
+            frames[frame][i] = value;
+        }
+    }
+    return frames;
+}
+
+// Reads every frame once sequentially and then in random order with repeats,
+// the two passes must agree bit for bit and stay within tolerance of the input
+static int checkFrames(std::mt19937 &generator, const std::string &name, const SpectrogramReader &reader,
+                       const std::vector<std::vector<float>> &frames)
+{
+    const SpectrogramHeader &header = reader.getHeader();
+    if (reader.getFrameCount() != frames.size())
+    {
+        std::cout << name << ": " << reader.getFrameCount() << " frames read back, " << frames.size() << " written" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::vector<float>> sequential(frames.size());
+    for (uint64_t frame = 0; frame < frames.size(); ++frame)
+    {
+        if (!reader.readFrame(frame, sequential[frame]))
+        {
+            std::cout << name << ": frame " << frame << " cannot be read" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<uint64_t> order;
+    for (uint64_t frame = 0; frame < frames.size(); ++frame)
+    {
+        order.push_back(frame);
+        order.push_back(frame);
+    }
+    std::shuffle(order.begin(), order.end(), generator);
+
+    int failures = 0;
+    float worstError = 0.0f;
+    std::vector<float> values;
+    for (uint64_t frame : order)
+    {
+        if (!reader.readFrame(frame, values) || values != sequential[frame])
+        {
+            std::cout << name << ": frame " << frame << " read out of order differs from the sequential read" << std::endl;
+            ++failures;
+            continue;
+        }
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            float error = std::fabs(values[i] - frames[frame][i]);
+            worstError = std::max(worstError, error);
+            if (error > getTolerance(header, frames[frame][i]))
+            {
+                std::cout << name << ": frame " << frame << " value " << i << " is " << values[i]
+                          << ", written as " << frames[frame][i] << std::endl;
+                ++failures;
+                break;
+            }
+        }
+    }
+
+    std::cout << name << ": worst error " << worstError << std::endl;
+    return failures;
+}
+
+static int checkFrameTimes(const std::string &name, const SpectrogramReader &reader)
+{
+    const SpectrogramHeader &header = reader.getHeader();
+    double hopSeconds = static_cast<double>(header.hopSize) / header.sampleRate;
+    uint64_t lastFrame = reader.getFrameCount() - 1;
+
+    int failures = 0;
+    for (uint64_t frame = 0; frame <= lastFrame; ++frame)
+    {
+        double time = reader.getFrameTime(frame);
+        if (reader.getFrameAtTime(time) != frame ||
+            reader.getFrameAtTime(time - 0.4 * hopSeconds) != frame ||
+            reader.getFrameAtTime(time + 0.4 * hopSeconds) != frame)
+        {
+            std::cout << name << ": times around frame " << frame << " do not map back to it" << std::endl;
+            ++failures;
+        }
+    }
+    if (std::fabs(reader.getFrameTime(0) - static_cast<double>(header.firstFrameSample) / header.sampleRate) > 1e-12 ||
+        reader.getFrameAtTime(0.0) != 0 ||
+        reader.getFrameAtTime(reader.getFrameTime(lastFrame) + 10.0) != lastFrame)
+    {
+        std::cout << name << ": times outside the file are not clamped to its frames" << std::endl;
+        ++failures;
+    }
+    return failures;
+}
+
+// Puts the file back in the state a writer that was never closed leaves it in:
+// the placeholder header with no frame count or index, and half a record more
+static void simulateUnclosedFile(const fs::path &path, size_t valuesPerFrame)
+{
+    std::vector<char> bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    std::memset(bytes.data() + 56, 0, 16);
+    bytes.insert(bytes.end(), valuesPerFrame / 2, '\x7F');
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+static int checkFile(std::mt19937 &generator, const FileCase &fileCase)
+{
+    std::string name = std::string(getEncodingName(fileCase.encoding)) +
+                       (fileCase.deltaCoded ? " delta/" + std::to_string(fileCase.keyframeInterval) : "");
+    fs::path path = fs::temp_directory_path() / ("SpectrogramFileTest_" + std::to_string(generator()) + ".spg");
+
+    SpectrogramHeader header = makeHeader(fileCase);
+    std::vector<std::vector<float>> frames = makeFrames(generator, header);
+
+    SpectrogramWriter writer;
+    if (!writer.open(path.string(), header))
+    {
+        std::cout << name << ": cannot create " << path << std::endl;
+        return 1;
+    }
+    for (const std::vector<float> &frame : frames)
+    {
+        writer.writeFrame(frame.data(), frame.size());
+    }
+    writer.close();
+
+    int failures = 0;
+    {
+        SpectrogramReader reader;
+        if (!reader.open(path.string()))
+        {
+            std::cout << name << ": cannot open what was written" << std::endl;
+            fs::remove(path);
+            return 1;
+        }
+        const SpectrogramHeader &readHeader = reader.getHeader();
+        if (readHeader.encoding != header.encoding || readHeader.deltaCoded != header.deltaCoded ||
+            readHeader.numBands != header.numBands || readHeader.numStreams != header.numStreams ||
+            readHeader.sampleRate != header.sampleRate || readHeader.hopSize != header.hopSize)
+        {
+            std::cout << name << ": header does not read back as written" << std::endl;
+            ++failures;
+        }
+        failures += checkFrames(generator, name, reader, frames);
+        failures += checkFrameTimes(name, reader);
+    }
+
+    simulateUnclosedFile(path, header.getValuesPerFrame());
+    {
+        // Delta coded frames cannot be found without the index, such a file reads as empty
+        SpectrogramReader reader;
+        if (!reader.open(path.string()))
+        {
+            std::cout << name << ": unclosed file cannot be opened" << std::endl;
+            ++failures;
+        }
+        else if (fileCase.deltaCoded)
+        {
+            if (reader.getFrameCount() != 0)
+            {
+                std::cout << name << ": unclosed delta coded file claims " << reader.getFrameCount() << " frames" << std::endl;
+                ++failures;
+            }
+        }
+        else
+        {
+            failures += checkFrames(generator, name + " unclosed", reader, frames);
+        }
+    }
+
+    fs::remove(path);
+    return failures;
+}
+
+int main()
+{
+    // Half floats are never delta coded
+    const FileCase fileCases[] = {
+        {SpectrogramEncoding::UInt8, false, 0},
+        {SpectrogramEncoding::UInt8, true, 0},
+        {SpectrogramEncoding::UInt8, true, 7},
+        {SpectrogramEncoding::UInt16, false, 0},
+        {SpectrogramEncoding::UInt16, true, 0},
+        {SpectrogramEncoding::UInt16, true, 7},
+        {SpectrogramEncoding::Float16, false, 0},
+    };
+
+    std::mt19937 generator(1234);
+    int failures = 0;
+    for (const FileCase &fileCase : fileCases)
+    {
+        failures += checkFile(generator, fileCase);
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,338 @@
+// Offline batch analysis: runs the visualizer's analysis pipeline over WAV files
+// as fast as the cores allow and writes one band time series per file.
+//
+// BatchAnalyzer [options] <file or directory>...
+//   -o <dir>           output directory, default "."
+//   --bands <n>        frequency windows per stream, default 12
+//   --fft <n>          analysis window size, default 2048
+//   --hop <n>          hop size, default fft / 4
+//   --window <name>    hann, hamming, blackmanharris, flattop, kaiser, rectangular
+//   --scale <name>     log, linear, mel, bark
+//   --mode <name>      fft, constantq, slidingdft, auto
+//   --channels <name>  downmix, perchannel, midside
+//   --rate <hz>        resample to this rate before analysis, default the file's rate
+//   --threads <n>      worker threads, default one per core
+//   --format <name>    csv, u8, u16 or f16, default csv
+//   --delta            delta code u8 and u16 spectrogram files
+//
+// Directories are searched recursively for .wav files and the output mirrors
+// their layout. A CSV output has the end time of every frame in seconds followed
+// by its band values, the other formats write a .spg spectrogram file with values
+// of that encoding (see SpectrogramFile.h).
+
+#include "AnalysisPipeline.h"
+#include "WavFileSource.h"
+#include "WorkStealingPool.h"
+#include "SpectrogramFile.h"
+
+#include <filesystem>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace fs = std::filesystem;
+
+struct BatchJob
+{
+    fs::path input;
+    fs::path output;
+};
+
+struct BatchOptions
+{
+    fs::path outputDirectory = ".";
+    unsigned int numBands = 12;
+    size_t numThreads = 0;
+    bool writeCsv = true;
+    SpectrogramEncoding encoding = SpectrogramEncoding::UInt8;
+    bool deltaCoded = false;
+    AnalysisSettings settings;
+    std::vector<fs::path> inputs;
+};
+
+static void printUsage()
+{
+    std::cerr << "Usage: BatchAnalyzer [-o dir] [--bands n] [--fft n] [--hop n] [--window name] [--scale name]\n"
+                 "                     [--mode name] [--channels name] [--rate hz] [--threads n] [--format csv|u8|u16|f16] [--delta]\n"
+                 "                     <file or directory>...\n";
+}
+
+static bool parseFormat(const std::string &name, BatchOptions &options)
+{
+    options.writeCsv = name == "csv";
+    if (name == "u8")
+        options.encoding = SpectrogramEncoding::UInt8;
+    else if (name == "u16")
+        options.encoding = SpectrogramEncoding::UInt16;
+    else if (name == "f16")
+        options.encoding = SpectrogramEncoding::Float16;
+    else if (!options.writeCsv)
+        return false;
+    return true;
+}
+
+static bool parseOptions(int argc, char **argv, BatchOptions &options)
+{
+    size_t hopSize = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--delta")
+        {
+            options.deltaCoded = true;
+            continue;
+        }
+
+        bool hasValue = i + 1 < argc;
+        if (argument.size() > 1 && argument[0] == '-' && !hasValue)
+        {
+            std::cerr << "Missing value for " << argument << std::endl;
+            return false;
+        }
+
+        if (argument == "-o")
+            options.outputDirectory = argv[++i];
+        else if (argument == "--bands")
+            options.numBands = std::strtoul(argv[++i], nullptr, 10);
+        else if (argument == "--fft")
+            options.settings.windowSize = std::strtoul(argv[++i], nullptr, 10);
+        else if (argument == "--hop")
+            hopSize = std::strtoul(argv[++i], nullptr, 10);
+        else if (argument == "--window")
+            options.settings.windowType = parseWindowType(argv[++i]);
+        else if (argument == "--scale")
+            options.settings.frequencyScale = parseFrequencyScale(argv[++i]);
+        else if (argument == "--mode")
+            options.settings.mode = parseAnalysisMode(argv[++i]);
+        else if (argument == "--channels")
+            options.settings.channelMode = parseChannelMode(argv[++i]);
+        else if (argument == "--rate")
+            options.settings.analysisSampleRate = std::strtoul(argv[++i], nullptr, 10);
+        else if (argument == "--threads")
+            options.numThreads = std::strtoul(argv[++i], nullptr, 10);
+        else if (argument == "--format")
+        {
+            if (!parseFormat(argv[++i], options))
+            {
+                std::cerr << "Unknown format " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if (argument.size() > 1 && argument[0] == '-')
+        {
+            std::cerr << "Unknown option " << argument << std::endl;
+            return false;
+        }
+        else
+            options.inputs.push_back(argument);
+    }
+
+    options.settings.hopSize = hopSize != 0 ? hopSize : options.settings.windowSize / 4;
+    if (options.inputs.empty() || options.numBands == 0 || options.settings.windowSize == 0 || options.settings.hopSize == 0)
+    {
+        return false;
+    }
+    return true;
+}
+
+static bool isWavFile(const fs::path &path)
+{
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c)
+                   { return static_cast<char>(std::tolower(c)); });
+    return extension == ".wav";
+}
+
+static std::vector<BatchJob> collectJobs(const BatchOptions &options)
+{
+    std::vector<BatchJob> jobs;
+    const char *extension = options.writeCsv ? ".csv" : ".spg";
+    for (const fs::path &input : options.inputs)
+    {
+        std::error_code error;
+        if (fs::is_directory(input, error))
+        {
+            for (const fs::directory_entry &entry : fs::recursive_directory_iterator(input, error))
+            {
+                if (entry.is_regular_file(error) && isWavFile(entry.path()))
+                {
+                    fs::path output = options.outputDirectory / fs::relative(entry.path(), input, error);
+                    jobs.push_back({entry.path(), output.replace_extension(extension)});
+                }
+            }
+        }
+        else
+        {
+            fs::path output = options.outputDirectory / input.filename();
+            jobs.push_back({input, output.replace_extension(extension)});
+        }
+    }
+    return jobs;
+}
+
+// Analyses one file and returns its duration in seconds, negative on failure
+static double analyseFile(const BatchJob &job, const BatchOptions &options)
+{
+    // One hop per packet, so every packet completes at most one frame and no
+    // published frame is overwritten before it is written out. Resampling up
+    // stretches a packet, so it gets as many file frames as make a hop at the
+    // analysis rate.
+    size_t framesPerPacket = options.settings.hopSize;
+    {
+        WavFileSource probe(job.input.string());
+        if (!probe.initialize())
+        {
+            return -1.0;
+        }
+        if (options.settings.analysisSampleRate > probe.getSampleRate())
+        {
+            framesPerPacket = std::max<size_t>(1, static_cast<size_t>(options.settings.hopSize * probe.getSampleRate() / options.settings.analysisSampleRate));
+        }
+    }
+    WavFileSource source(job.input.string(), ReplayPacing::AsFastAsPossible, framesPerPacket);
+    if (!source.initialize())
+    {
+        return -1.0;
+    }
+
+    std::error_code error;
+    fs::create_directories(job.output.parent_path(), error);
+    std::ofstream output;
+    if (options.writeCsv)
+    {
+        output.open(job.output, std::ios::binary);
+        if (!output.is_open())
+        {
+            return -1.0;
+        }
+    }
+
+    AnalysisPipeline pipeline(options.numBands, source.getSampleRate(), source.getChannelCount(), options.settings);
+    source.startCapture();
+
+    SpectrogramWriter spectrogram;
+    SpectrogramHeader header;
+    header.sampleRate = static_cast<uint32_t>(pipeline.getSampleRate());
+    header.fftSize = static_cast<uint32_t>(options.settings.windowSize);
+    header.hopSize = static_cast<uint32_t>(options.settings.hopSize);
+    header.numBands = options.numBands;
+    header.numStreams = static_cast<uint32_t>(getChannelModeStreamCount(options.settings.channelMode, source.getChannelCount()));
+    header.frequencyScale = options.settings.frequencyScale;
+    header.lowerFrequency = static_cast<float>(pipeline.getLowerFrequency());
+    header.upperFrequency = static_cast<float>(pipeline.getUpperFrequency());
+    header.encoding = options.encoding;
+    header.deltaCoded = options.deltaCoded;
+
+    SpectrumFrame frame;
+    std::string line;
+    char number[32];
+    unsigned long long framesRead = 0;
+    const float *samples = nullptr;
+    size_t numSamples = 0;
+    LatencyTracer::Clock::time_point captureTime;
+    while (source.tryAcquireBuffer(samples, numSamples, captureTime) == AcquireResult::Packet)
+    {
+        framesRead += numSamples / std::max(source.getChannelCount(), 1u);
+
+        // Default timestamps keep offline work out of the latency histograms
+        if (!pipeline.processPacket(samples, numSamples, LatencyTracer::Clock::time_point(), LatencyTracer::Clock::time_point()))
+        {
+            continue;
+        }
+        pipeline.readSpectrum(frame);
+
+        if (!options.writeCsv)
+        {
+            // Opened at the first frame, whose position the header records
+            if (!spectrogram.isOpen())
+            {
+                header.firstFrameSample = static_cast<uint32_t>(std::llround(framesRead * pipeline.getSampleRate() / source.getSampleRate()));
+                if (!spectrogram.open(job.output.string(), header))
+                {
+                    return -1.0;
+                }
+            }
+            if (!spectrogram.writeFrame(frame.magnitudes.data(), frame.magnitudes.size()))
+            {
+                return -1.0;
+            }
+            continue;
+        }
+
+        std::snprintf(number, sizeof(number), "%.6f", framesRead / static_cast<double>(source.getSampleRate()));
+        line = number;
+        for (float magnitude : frame.magnitudes)
+        {
+            std::snprintf(number, sizeof(number), ",%.6g", magnitude);
+            line += number;
+        }
+        line += '\n';
+        output.write(line.data(), line.size());
+    }
+
+    // Files shorter than one window still get an empty spectrogram
+    if (!options.writeCsv && !spectrogram.isOpen() && !spectrogram.open(job.output.string(), header))
+    {
+        return -1.0;
+    }
+    bool ok = options.writeCsv ? output.good() : spectrogram.close();
+    return ok ? source.getFrameCount() / static_cast<double>(source.getSampleRate()) : -1.0;
+}
+
+int main(int argc, char **argv)
+{
+    BatchOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 2;
+    }
+
+    std::vector<BatchJob> jobs = collectJobs(options);
+    if (jobs.empty())
+    {
+        std::cerr << "No WAV files found" << std::endl;
+        return 1;
+    }
+
+    std::atomic<int> failures(0);
+    std::atomic<long long> audioMicroseconds(0);
+    std::mutex logMutex;
+    auto start = std::chrono::steady_clock::now();
+    size_t numThreads;
+    {
+        // One task per file, the pool spreads them over the cores
+        WorkStealingPool pool(options.numThreads);
+        numThreads = pool.getThreadCount();
+        for (const BatchJob &job : jobs)
+        {
+            pool.submit([&, job]()
+                        {
+                double seconds = analyseFile(job, options);
+                if (seconds < 0.0)
+                {
+                    ++failures;
+                    std::lock_guard<std::mutex> lock(logMutex);
+                    std::cerr << "Failed to analyse " << job.input.string() << std::endl;
+                    return;
+                }
+                audioMicroseconds += static_cast<long long>(seconds * 1e6); });
+        }
+        pool.waitIdle();
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double audioSeconds = audioMicroseconds / 1e6;
+
+    std::cerr << jobs.size() - failures << " of " << jobs.size() << " files, "
+              << audioSeconds << " s of audio in " << wallSeconds << " s on " << numThreads << " threads ("
+              << (wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0) << "x real time)" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
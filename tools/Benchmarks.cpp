@@ -0,0 +1,563 @@
+// Microbenchmarks of the analysis and rendering hot paths, runs without an audio device or a window.
+//
+// Benchmarks [options]
+//   --filter <text>    only run benchmarks whose name contains text
+//   --min-time <ms>    minimum measured time per repetition, default 100
+//   --repetitions <n>  measured repetitions per benchmark, default 5
+//   --format <name>    text, csv or json, default text
+//   --list             print the benchmark names and exit
+//
+// Every benchmark is calibrated to run at least the minimum time, then measured
+// several times. ns/op is the median repetition, allocations and bytes per op
+// come from the replaced global operator new and cover everything the operation
+// allocates. The csv and json formats print one record per benchmark so runs can
+// be compared by a script.
+
+#include "FFT.h"
+#include "AnalysisPipeline.h"
+#include "INIFileParser.h"
+#include "SPSCRingBuffer.h"
+#include "SampleFormat.h"
+#include "PolyphaseResampler.h"
+#include "SoftwareBarRenderer.h"
+#include "ImageWriter.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <new>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+static std::atomic<unsigned long long> allocationCount(0);
+static std::atomic<unsigned long long> allocatedBytes(0);
+
+void *operator new(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+// Every delete form frees through here. Out of line, GCC would otherwise see
+// free() or a scalar delete on the result of a new expression and warn.
+__attribute__((noinline)) static void releaseMemory(void *memory)
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory) noexcept
+{
+    releaseMemory(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    releaseMemory(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    releaseMemory(memory);
+}
+
+void operator delete[](void *memory, size_t) noexcept
+{
+    releaseMemory(memory);
+}
+
+// Keeps the compiler from dropping a result nobody reads
+template <typename T>
+static void doNotOptimize(const T &value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct Benchmark
+{
+    std::string name;
+    // Runs the operation iterations times
+    std::function<void(size_t iterations)> run;
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    unsigned long long iterations = 0;
+    double nsPerOp = 0.0;
+    double minNsPerOp = 0.0;
+    double allocationsPerOp = 0.0;
+    double bytesPerOp = 0.0;
+};
+
+struct BenchmarkOptions
+{
+    std::string filter;
+    double minTimeMs = 100.0;
+    unsigned int repetitions = 5;
+    std::string format = "text";
+    bool list = false;
+};
+
+// Sine at a bin centre plus a little noise, the same every run
+static std::vector<float> makeSignal(size_t numSamples, unsigned int numChannels, double sampleRate)
+{
+    std::vector<float> signal(numSamples * numChannels);
+    unsigned int seed = 1;
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        float noise = (static_cast<float>(seed) / 4294967296.0f - 0.5f) * 0.1f;
+        float sine = 0.5f * static_cast<float>(std::sin(2.0 * M_PI * 1000.0 * i / sampleRate));
+        for (unsigned int channel = 0; channel < numChannels; ++channel)
+        {
+            signal[i * numChannels + channel] = sine + noise;
+        }
+    }
+    return signal;
+}
+
+static std::vector<std::complex<double>> makeComplexSignal(size_t size)
+{
+    std::vector<float> signal = makeSignal(size, 1, 48000.0);
+    return std::vector<std::complex<double>>(signal.begin(), signal.end());
+}
+
+static void addFFTBenchmarks(std::vector<Benchmark> &benchmarks)
+{
+    for (size_t size = 256; size <= 65536; size *= 4)
+    {
+        benchmarks.push_back({"fft/" + std::to_string(size), [size](size_t iterations)
+                              {
+                                  std::vector<std::complex<double>> samples = makeComplexSignal(size);
+                                  for (size_t i = 0; i < iterations; ++i)
+                                  {
+                                      doNotOptimize(fft(samples));
+                                  }
+                              }});
+    }
+
+    for (size_t size = 256; size <= 65536; size *= 4)
+    {
+        benchmarks.push_back({"bitReverse/" + std::to_string(size), [size](size_t iterations)
+                              {
+                                  std::vector<std::complex<double>> samples = makeComplexSignal(size);
+                                  for (size_t i = 0; i < iterations; ++i)
+                                  {
+                                      bitReverse(samples);
+                                      doNotOptimize(samples);
+                                  }
+                              }});
+    }
+
+    // The plan the pipeline actually runs, for comparison with the reference above
+    for (size_t size = 256; size <= 65536; size *= 4)
+    {
+        benchmarks.push_back({"FFTPlan::executeReal/" + std::to_string(size), [size](size_t iterations)
+                              {
+                                  FFTPlan plan(size);
+                                  std::vector<float> samples = makeSignal(size, 1, 48000.0);
+                                  std::vector<std::complex<float>> bins(size / 2 + 1);
+                                  for (size_t i = 0; i < iterations; ++i)
+                                  {
+                                      plan.executeReal(samples, bins);
+                                      doNotOptimize(bins);
+                                  }
+                              }});
+    }
+}
+
+static void addPipelineStepBenchmarks(std::vector<Benchmark> &benchmarks)
+{
+    for (unsigned int numBands : {12u, 32u, 64u, 128u, 256u, 512u})
+    {
+        benchmarks.push_back({"calculateFrequencyWindowMagnitudes/" + std::to_string(numBands), [numBands](size_t iterations)
+                              {
+                                  AnalysisPipeline pipeline(numBands, 48000.0, 1);
+                                  AnalysisSettings settings;
+                                  std::vector<float> frame = makeSignal(settings.windowSize, 1, 48000.0);
+                                  std::vector<float> bands(numBands);
+                                  for (size_t i = 0; i < iterations; ++i)
+                                  {
+                                      pipeline.calculateFrequencyWindowMagnitudes(frame, bands);
+                                      doNotOptimize(bands);
+                                  }
+                              }});
+    }
+
+    for (unsigned int numBands : {12u, 512u})
+    {
+        benchmarks.push_back({"modifyLogAlternation/" + std::to_string(numBands), [numBands](size_t iterations)
+                              {
+                                  AnalysisPipeline pipeline(numBands, 48000.0, 1);
+                                  std::vector<float> bands(numBands, 1.0f);
+                                  for (size_t i = 0; i < iterations; ++i)
+                                  {
+                                      // Reset the values so they do not decay to zero over the run
+                                      std::fill(bands.begin(), bands.end(), 100.0f);
+                                      pipeline.modifyLogAlternation(bands);
+                                      doNotOptimize(bands);
+                                  }
+                              }});
+    }
+}
+
+// One 10 ms stereo packet per op, converted or resampled the way capture hands it over
+static void addFormatBenchmarks(std::vector<Benchmark> &benchmarks)
+{
+    const size_t packetSamples = 480 * 2;
+    for (SampleFormat format : {SampleFormat::Int16, SampleFormat::Int24, SampleFormat::Int32})
+    {
+        benchmarks.push_back({std::string("convertSamples/") + getSampleFormatName(format), [format, packetSamples](size_t iterations)
+                              {
+                                  std::vector<unsigned char> packet(packetSamples * getSampleFormatSize(format));
+                                  for (size_t i = 0; i < packet.size(); ++i)
+                                  {
+                                      packet[i] = static_cast<unsigned char>(i * 7);
+                                  }
+                                  std::vector<float> samples(packetSamples);
+                                  for (size_t i = 0; i < iterations; ++i)
+                                  {
+                                      convertSamples(format, packet.data(), packetSamples, samples.data());
+                                      doNotOptimize(samples);
+                                  }
+                              }});
+    }
+
+    for (unsigned int inputRate : {44100u, 96000u})
+    {
+        benchmarks.push_back({"PolyphaseResampler/" + std::to_string(inputRate) + "-48000", [inputRate](size_t iterations)
+                              {
+                                  PolyphaseResampler resampler(inputRate, 48000, 2);
+                                  size_t packetFrames = inputRate / 100;
+                                  std::vector<float> packet = makeSignal(packetFrames, 2, inputRate);
+                                  std::vector<float> output;
+                                  for (size_t i = 0; i < iterations; ++i)
+                                  {
+                                      resampler.process(packet.data(), packetFrames, output);
+                                      doNotOptimize(output);
+                                  }
+                              }});
+    }
+}
+
+// One frame of the bar display on the CPU, smoothing included, and its PNG encoding
+static void addRenderBenchmarks(std::vector<Benchmark> &benchmarks)
+{
+    struct FrameSize
+    {
+        int width;
+        int height;
+    };
+    for (FrameSize size : {FrameSize{1280, 360}, FrameSize{1920, 1080}})
+    {
+        std::string name = std::to_string(size.width) + "x" + std::to_string(size.height);
+        benchmarks.push_back({"SoftwareBarRenderer::render/" + name, [size](size_t iterations)
+                              {
+                                  SoftwareBarRenderer renderer;
+                                  BarSmoother smoother;
+                                  std::vector<float> targets(12);
+                                  for (size_t i = 0; i < iterations; ++i)
+                                  {
+                                      for (size_t band = 0; band < targets.size(); ++band)
+                                      {
+                                          targets[band] = static_cast<float>((i + band * 5) % 17) / 17.0f;
+                                      }
+                                      renderer.render(smoother.update(targets, 1.0f / 60.0f), size.width, size.height, BarColor());
+                                      doNotOptimize(renderer.getPixels()[0]);
+                                  }
+                              }});
+        benchmarks.push_back({"encodePNGImage/" + name, [size](size_t iterations)
+                              {
+                                  SoftwareBarRenderer renderer;
+                                  std::vector<float> heights(12);
+                                  for (size_t band = 0; band < heights.size(); ++band)
+                                  {
+                                      heights[band] = static_cast<float>(band) / heights.size();
+                                  }
+                                  renderer.render(heights, size.width, size.height, BarColor());
+                                  std::vector<unsigned char> png;
+                                  for (size_t i = 0; i < iterations; ++i)
+                                  {
+                                      encodePNGImage(renderer.getPixels(), size.width, size.height, png);
+                                      doNotOptimize(png);
+                                  }
+                              }});
+    }
+}
+
+static void addSettingsBenchmarks(std::vector<Benchmark> &benchmarks, const std::string &iniPath)
+{
+    benchmarks.push_back({"INIFileParser::load", [iniPath](size_t iterations)
+                          {
+                              for (size_t i = 0; i < iterations; ++i)
+                              {
+                                  INIFileParser parser;
+                                  doNotOptimize(parser.load(iniPath));
+                              }
+                          }});
+
+    benchmarks.push_back({"INIFileParser::getSetting<int>", [iniPath](size_t iterations)
+                          {
+                              INIFileParser parser(iniPath);
+                              for (size_t i = 0; i < iterations; ++i)
+                              {
+                                  doNotOptimize(parser.getSetting<int>("numBars"));
+                              }
+                          }});
+
+    benchmarks.push_back({"INIFileParser::getSetting<string>", [iniPath](size_t iterations)
+                          {
+                              INIFileParser parser(iniPath);
+                              for (size_t i = 0; i < iterations; ++i)
+                              {
+                                  doNotOptimize(parser.getSetting<std::string>("windowFunction"));
+                              }
+                          }});
+}
+
+// Capture to published spectrum: 10 ms stereo packets go through the ring buffer
+// the capture thread fills and are analysed in place, one packet per op
+static void addEndToEndBenchmarks(std::vector<Benchmark> &benchmarks)
+{
+    struct Configuration
+    {
+        const char *name;
+        AnalysisMode mode;
+        unsigned int numBands;
+    };
+    const Configuration configurations[] = {
+        {"fft/12", AnalysisMode::FFT, 12},
+        {"fft/128", AnalysisMode::FFT, 128},
+        {"constantq/12", AnalysisMode::ConstantQ, 12},
+        {"slidingdft/12", AnalysisMode::SlidingDFT, 12},
+    };
+
+    for (const Configuration &configuration : configurations)
+    {
+        benchmarks.push_back({std::string("pipeline/") + configuration.name, [configuration](size_t iterations)
+                              {
+                                  const double sampleRate = 48000.0;
+                                  const unsigned int numChannels = 2;
+                                  const size_t packetSamples = 480 * numChannels;
+
+                                  AnalysisSettings settings;
+                                  settings.mode = configuration.mode;
+                                  AnalysisPipeline pipeline(configuration.numBands, sampleRate, numChannels, settings);
+                                  SPSCRingBuffer ring(static_cast<size_t>(sampleRate) * numChannels);
+                                  std::vector<float> signal = makeSignal(static_cast<size_t>(sampleRate), numChannels, sampleRate);
+                                  pipeline.prepare();
+
+                                  size_t signalOffset = 0;
+                                  for (size_t i = 0; i < iterations; ++i)
+                                  {
+                                      ring.write(signal.data() + signalOffset, packetSamples);
+                                      signalOffset = (signalOffset + packetSamples) % (signal.size() - packetSamples);
+
+                                      // The ring can wrap inside a packet, analyse each contiguous run
+                                      const float *samples = nullptr;
+                                      size_t available;
+                                      while ((available = ring.peek(samples)) > 0)
+                                      {
+                                          available -= available % numChannels;
+                                          pipeline.processPacket(samples, available, LatencyTracer::Clock::time_point(), LatencyTracer::Clock::time_point());
+                                          ring.consume(available);
+                                      }
+                                  }
+                                  doNotOptimize(pipeline.getSequence());
+                              }});
+    }
+}
+
+static double measure(const Benchmark &benchmark, size_t iterations)
+{
+    auto start = std::chrono::steady_clock::now();
+    benchmark.run(iterations);
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static BenchmarkResult runBenchmark(const Benchmark &benchmark, const BenchmarkOptions &options)
+{
+    // Grow the iteration count until one run takes the minimum time
+    const double minTimeNs = options.minTimeMs * 1e6;
+    size_t iterations = 1;
+    double elapsed = measure(benchmark, iterations);
+    while (elapsed < minTimeNs && iterations < (size_t(1) << 40))
+    {
+        double scale = elapsed > 0.0 ? minTimeNs / elapsed * 1.2 : 100.0;
+        iterations = static_cast<size_t>(iterations * std::min(std::max(scale, 2.0), 100.0));
+        elapsed = measure(benchmark, iterations);
+    }
+
+    // Setup and warm-up allocations are the same for any iteration count, so the
+    // difference between a run of n and one of 2n iterations is what n operations
+    // allocate. n is kept large enough for lazily sized buffers, such as the
+    // first analysis frame of the pipeline, to be allocated within the first run.
+    const size_t allocationIterations = std::max<size_t>(iterations, 16);
+    unsigned long long allocationsBefore = allocationCount.load();
+    unsigned long long bytesBefore = allocatedBytes.load();
+    benchmark.run(allocationIterations);
+    unsigned long long singleAllocations = allocationCount.load() - allocationsBefore;
+    unsigned long long singleBytes = allocatedBytes.load() - bytesBefore;
+    allocationsBefore = allocationCount.load();
+    bytesBefore = allocatedBytes.load();
+    benchmark.run(2 * allocationIterations);
+    unsigned long long doubleAllocations = allocationCount.load() - allocationsBefore;
+    unsigned long long doubleBytes = allocatedBytes.load() - bytesBefore;
+
+    std::vector<double> nsPerOp;
+    for (unsigned int repetition = 0; repetition < options.repetitions; ++repetition)
+    {
+        nsPerOp.push_back(measure(benchmark, iterations) / iterations);
+    }
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+
+    BenchmarkResult result;
+    result.name = benchmark.name;
+    result.iterations = iterations;
+    result.nsPerOp = nsPerOp[nsPerOp.size() / 2];
+    result.minNsPerOp = nsPerOp.front();
+    result.allocationsPerOp = std::max(0.0, (static_cast<double>(doubleAllocations) - singleAllocations) / allocationIterations);
+    result.bytesPerOp = std::max(0.0, (static_cast<double>(doubleBytes) - singleBytes) / allocationIterations);
+    return result;
+}
+
+static std::string escapeJson(const std::string &text)
+{
+    std::string escaped;
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+static void printResult(const BenchmarkResult &result, const std::string &format, bool first)
+{
+    char line[512];
+    if (format == "csv")
+    {
+        if (first)
+            std::cout << "name,iterations,ns_per_op,min_ns_per_op,allocs_per_op,bytes_per_op\n";
+        std::snprintf(line, sizeof(line), "%s,%llu,%.2f,%.2f,%.3f,%.1f\n", result.name.c_str(), result.iterations,
+                      result.nsPerOp, result.minNsPerOp, result.allocationsPerOp, result.bytesPerOp);
+    }
+    else if (format == "json")
+    {
+        std::snprintf(line, sizeof(line), "%s\n    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.2f, \"min_ns_per_op\": %.2f, \"allocs_per_op\": %.3f, \"bytes_per_op\": %.1f}",
+                      first ? "" : ",", escapeJson(result.name).c_str(), result.iterations, result.nsPerOp,
+                      result.minNsPerOp, result.allocationsPerOp, result.bytesPerOp);
+    }
+    else
+    {
+        if (first)
+        {
+            std::snprintf(line, sizeof(line), "%-44s %12s %14s %14s %12s %14s\n", "benchmark", "iterations",
+                          "ns/op", "min ns/op", "allocs/op", "bytes/op");
+            std::cout << line;
+        }
+        std::snprintf(line, sizeof(line), "%-44s %12llu %14.1f %14.1f %12.2f %14.1f\n", result.name.c_str(),
+                      result.iterations, result.nsPerOp, result.minNsPerOp, result.allocationsPerOp, result.bytesPerOp);
+    }
+    std::cout << line << std::flush;
+}
+
+static bool parseOptions(int argc, char **argv, BenchmarkOptions &options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--list")
+        {
+            options.list = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << argument << std::endl;
+            return false;
+        }
+
+        if (argument == "--filter")
+            options.filter = argv[++i];
+        else if (argument == "--min-time")
+            options.minTimeMs = std::strtod(argv[++i], nullptr);
+        else if (argument == "--repetitions")
+            options.repetitions = std::strtoul(argv[++i], nullptr, 10);
+        else if (argument == "--format")
+            options.format = argv[++i];
+        else
+        {
+            std::cerr << "Unknown option " << argument << std::endl;
+            return false;
+        }
+    }
+    return options.repetitions > 0 && options.minTimeMs >= 0.0 &&
+           (options.format == "text" || options.format == "csv" || options.format == "json");
+}
+
+int main(int argc, char **argv)
+{
+    BenchmarkOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cerr << "Usage: Benchmarks [--filter text] [--min-time ms] [--repetitions n] [--format text|csv|json] [--list]\n";
+        return 2;
+    }
+
+    // A settings file like the shipped one, so the parser benchmarks do not depend
+    // on the working directory
+    std::string iniPath = "benchmark_settings.ini";
+    {
+        std::ofstream ini(iniPath);
+        ini << "analysisMode=fft\nchannelMode=downmix\ncolor_alpha=1\ncolor_blue=1\ncolor_green=1\ncolor_red=1\n"
+               "fftSize=2048\nfrequencyScale=log\nhopSize=512\nlatencyDumpSeconds=0\nnumBars=12\nwindowFunction=hann\n"
+               "windowHeight=200\nwindowPosX=760\nwindowPosY=740\nwindowWidth=400\n";
+    }
+
+    std::vector<Benchmark> benchmarks;
+    addFFTBenchmarks(benchmarks);
+    addPipelineStepBenchmarks(benchmarks);
+    addFormatBenchmarks(benchmarks);
+    addRenderBenchmarks(benchmarks);
+    addSettingsBenchmarks(benchmarks, iniPath);
+    addEndToEndBenchmarks(benchmarks);
+
+    bool first = true;
+    bool json = options.format == "json" && !options.list;
+    if (json)
+        std::cout << "{\"benchmarks\": [";
+    for (const Benchmark &benchmark : benchmarks)
+    {
+        if (benchmark.name.find(options.filter) == std::string::npos)
+            continue;
+        if (options.list)
+        {
+            std::cout << benchmark.name << "\n";
+            continue;
+        }
+        printResult(runBenchmark(benchmark, options), options.format, first);
+        first = false;
+    }
+    if (json)
+        std::cout << "\n]}\n";
+
+    std::remove(iniPath.c_str());
+    return 0;
+}
@@ -0,0 +1,185 @@
+// Offline video export: plays a WAV file through the analysis pipeline and the
+// bar smoothing, renders every video frame on the CPU and writes them as one
+// uncompressed video stream, much faster than real time.
+//
+// ExportVideo [options] -o <file or -> <file.wav>
+//   -o <path>          output stream, "-" for standard output
+//   --format <name>    y4m or rgba, default y4m
+//   --fps <n>          video frames per second, default 60
+//   --size <w>x<h>     frame size in pixels, default 1280x360
+//   --bands <n>        frequency windows, default 12
+//   --fft <n>          analysis window size, default 2048
+//   --hop <n>          hop size, default fft / 4
+//   --mode <name>      fft, constantq, slidingdft, auto
+//   --rate <hz>        resample to this rate before analysis, default the file's rate
+//   --color <r,g,b,a>  bar colour with components from 0 to 1, default 1,1,1,1
+//   --threads <n>      render threads, default one per core
+//
+// The analysis and the smoothing run in order on the main thread, each frame's
+// bar heights depend on the ones before. Rendering and pixel format conversion
+// do not, so frames are rendered on all cores into a ring of slots and written
+// back in order as the oldest one completes. The ring bounds the memory to a
+// few frames per thread whatever the length of the audio.
+//
+//   ExportVideo -o - song.wav | ffmpeg -i - -i song.wav -c:v libx264 -c:a aac -shortest video.mp4
+
+#include "BarTimeline.h"
+#include "SoftwareBarRenderer.h"
+#include "VideoWriter.h"
+#include "WorkStealingPool.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdlib>
+
+struct ExportOptions
+{
+    std::string output;
+    VideoFormat format = VideoFormat::Y4M;
+    size_t numThreads = 0;
+    BarVideoOptions video;
+};
+
+// A frame on its way through the ring: heights in, encoded pixels out
+struct FrameSlot
+{
+    std::vector<float> heights;
+    SoftwareBarRenderer renderer;
+    std::vector<unsigned char> encoded;
+    // Guarded by the ring's mutex
+    bool done = true;
+};
+
+static void printUsage()
+{
+    std::cerr << "Usage: ExportVideo -o <file or -> [--format y4m|rgba] [--fps n] [--size wxh] [--bands n] [--fft n] [--hop n]\n"
+                 "                   [--mode name] [--rate hz] [--color r,g,b,a] [--threads n] <file.wav>\n";
+}
+
+static bool parseOptions(int argc, char **argv, ExportOptions &options)
+{
+    bool parsed = parseBarVideoOptions(argc, argv, options.video, [&options](const std::string &argument, const char *value)
+                                       {
+        if (argument == "-o")
+            options.output = value;
+        else if (argument == "--format")
+        {
+            if (!parseVideoFormat(value, options.format))
+            {
+                std::cerr << "Unknown format " << value << std::endl;
+                return false;
+            }
+        }
+        else if (argument == "--threads")
+            options.numThreads = std::strtoul(value, nullptr, 10);
+        else
+        {
+            std::cerr << "Unknown option " << argument << std::endl;
+            return false;
+        }
+        return true; });
+    return parsed && !options.output.empty();
+}
+
+int main(int argc, char **argv)
+{
+    ExportOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 2;
+    }
+    const BarVideoOptions &bars = options.video;
+
+    BarTimeline timeline(bars);
+    if (!timeline.initialize())
+    {
+        std::cerr << "Failed to open " << bars.input << std::endl;
+        return 1;
+    }
+
+    VideoWriter video;
+    if (!video.open(options.output, options.format, bars.width, bars.height, bars.fps))
+    {
+        std::cerr << "Failed to open " << options.output << std::endl;
+        return 1;
+    }
+
+    WorkStealingPool pool(options.numThreads);
+    // Two slots per thread keep every thread busy while the oldest frame is written
+    std::vector<std::unique_ptr<FrameSlot>> ring(2 * pool.getThreadCount());
+    for (std::unique_ptr<FrameSlot> &slot : ring)
+    {
+        slot.reset(new FrameSlot());
+        slot->encoded.resize(video.getFrameSize());
+    }
+    std::mutex ringMutex;
+    std::condition_variable frameDone;
+
+    // Waits for the frame in the slot to be rendered and writes it out
+    bool writeFailed = false;
+    auto writeSlot = [&](FrameSlot &slot)
+    {
+        {
+            std::unique_lock<std::mutex> lock(ringMutex);
+            frameDone.wait(lock, [&slot]()
+                           { return slot.done; });
+        }
+        writeFailed = writeFailed || !video.writeFrame(slot.encoded.data());
+    };
+
+    std::vector<float> heights;
+    unsigned long long videoFrame = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (!writeFailed && timeline.nextFrame(heights))
+    {
+        // The slot's previous frame is the oldest one in flight, it goes out first
+        FrameSlot &slot = *ring[videoFrame % ring.size()];
+        if (videoFrame >= ring.size())
+        {
+            writeSlot(slot);
+        }
+        slot.heights.swap(heights);
+        {
+            std::lock_guard<std::mutex> lock(ringMutex);
+            slot.done = false;
+        }
+        pool.submit([&, slotPointer = &slot]()
+                    {
+            FrameSlot &task = *slotPointer;
+            task.renderer.render(task.heights, bars.width, bars.height, bars.color);
+            video.encodeFrame(task.renderer.getPixels(), task.encoded.data());
+            {
+                std::lock_guard<std::mutex> lock(ringMutex);
+                task.done = true;
+            }
+            frameDone.notify_all(); });
+        ++videoFrame;
+    }
+
+    // The frames still in flight, oldest first
+    unsigned long long firstInFlight = videoFrame > ring.size() ? videoFrame - ring.size() : 0;
+    for (unsigned long long n = firstInFlight; n < videoFrame; ++n)
+    {
+        writeSlot(*ring[n % ring.size()]);
+    }
+    pool.waitIdle();
+
+    if (!video.close() || writeFailed)
+    {
+        std::cerr << "Failed to write " << options.output << std::endl;
+        return 1;
+    }
+
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double videoSeconds = video.getFrameCount() / static_cast<double>(bars.fps);
+    std::cerr << video.getFrameCount() << " frames of " << bars.width << "x" << bars.height << " in " << wallSeconds
+              << " s on " << pool.getThreadCount() << " threads (" << (wallSeconds > 0.0 ? videoSeconds / wallSeconds : 0.0)
+              << "x real time)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,290 @@
+// Headless check of the GL bar renderers: creates OpenGL contexts through EGL
+// without a window (Mesa's llvmpipe is enough), renders bar frames into an
+// offscreen framebuffer and compares them pixel for pixel with
+// SoftwareBarRenderer, then times frames at growing bar counts. The instanced
+// renderer runs in a 3.3 core context, once with its persistently mapped height
+// buffer and once with the orphaned one, the immediate mode renderer in a
+// compatibility context for comparison. On llvmpipe the submit time includes the
+// vertex shading and triangle setup, which the driver does on the calling thread
+// and which grows with the bar count whatever the upload costs, and creating the
+// mapped renderer's fence waits for the whole frame.
+//
+// GLRenderCheck [options]
+//   --size <w>x<h>     frame size in pixels, default 1280x360
+//   --frames <n>       frames timed per bar count, default 200
+//   --png <dir>        also write the GL frames as PNG files for inspection
+//
+// Exits with 1 when a frame differs from the CPU one, 2 on bad options and 3
+// when no context could be created.
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "GLInstancedBarRenderer.h"
+#include "GLBarRenderer.h"
+#include "SoftwareBarRenderer.h"
+#include "ImageWriter.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+
+struct CheckOptions
+{
+    int width = 1280;
+    int height = 360;
+    size_t numFrames = 200;
+    std::string pngDirectory;
+};
+
+static void printUsage()
+{
+    std::cerr << "Usage: GLRenderCheck [--size wxh] [--frames n] [--png dir]\n";
+}
+
+static bool parseOptions(int argc, char **argv, CheckOptions &options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << argument << std::endl;
+            return false;
+        }
+
+        if (argument == "--size")
+        {
+            if (std::sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2)
+                return false;
+        }
+        else if (argument == "--frames")
+            options.numFrames = std::strtoul(argv[++i], nullptr, 10);
+        else if (argument == "--png")
+            options.pngDirectory = argv[++i];
+        else
+        {
+            std::cerr << "Unknown option " << argument << std::endl;
+            return false;
+        }
+    }
+    return options.width > 0 && options.height > 0 && options.numFrames > 0;
+}
+
+// A current OpenGL 3.3 context with no surface, on the surfaceless platform when
+// the EGL implementation has it, and an offscreen RGBA8 framebuffer to draw into
+struct HeadlessContext
+{
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+    GLuint framebuffer = 0;
+    GLuint colorBuffer = 0;
+
+    bool create(bool coreProfile, int width, int height)
+    {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        if (getPlatformDisplay && clientExtensions && std::strstr(clientExtensions, "EGL_MESA_platform_surfaceless"))
+        {
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+        if (display == EGL_NO_DISPLAY)
+        {
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr) || !eglBindAPI(EGL_OPENGL_API))
+        {
+            std::cerr << "Failed to initialize EGL" << std::endl;
+            return false;
+        }
+
+        const EGLint configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+        EGLConfig config = nullptr;
+        EGLint numConfigs = 0;
+        eglChooseConfig(display, configAttributes, &config, 1, &numConfigs);
+
+        const EGLint contextAttributes[] = {EGL_CONTEXT_MAJOR_VERSION, 3,
+                                            EGL_CONTEXT_MINOR_VERSION, 3,
+                                            EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                            coreProfile ? EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT : EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+                                            EGL_NONE};
+        context = eglCreateContext(display, numConfigs > 0 ? config : nullptr, EGL_NO_CONTEXT, contextAttributes);
+        if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+        {
+            std::cerr << "Failed to create a surfaceless OpenGL 3.3 context" << std::endl;
+            return false;
+        }
+        if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress)))
+        {
+            std::cerr << "Failed to initialize GLAD" << std::endl;
+            return false;
+        }
+        std::cerr << "OpenGL " << glGetString(GL_VERSION) << " on " << glGetString(GL_RENDERER) << std::endl;
+
+        glGenFramebuffers(1, &framebuffer);
+        glGenRenderbuffers(1, &colorBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            std::cerr << "Offscreen framebuffer is incomplete" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    ~HeadlessContext()
+    {
+        if (context != EGL_NO_CONTEXT)
+        {
+            glDeleteRenderbuffers(1, &colorBuffer);
+            glDeleteFramebuffers(1, &framebuffer);
+            eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            eglDestroyContext(display, context);
+        }
+        if (display != EGL_NO_DISPLAY)
+        {
+            eglTerminate(display);
+        }
+    }
+};
+
+// Heights of frame n, every bar moving at its own rate between 0 and 1
+static void makeHeights(size_t numBars, size_t frame, std::vector<float> &heights)
+{
+    heights.resize(numBars);
+    for (size_t i = 0; i < numBars; ++i)
+    {
+        heights[i] = static_cast<float>((frame * (i % 7 + 1) + i * 13) % 101) / 100.0f;
+    }
+}
+
+// Reads the framebuffer back with the rows top to bottom like the CPU frame
+static void readPixels(int width, int height, std::vector<unsigned char> &pixels)
+{
+    size_t rowBytes = static_cast<size_t>(width) * 4;
+    std::vector<unsigned char> bottomUp(rowBytes * height);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, bottomUp.data());
+    pixels.resize(bottomUp.size());
+    for (int y = 0; y < height; ++y)
+    {
+        std::memcpy(pixels.data() + y * rowBytes, bottomUp.data() + (height - 1 - y) * rowBytes, rowBytes);
+    }
+}
+
+// Compares and times one renderer, false when a frame differs from the CPU one
+static bool checkRenderer(BarRenderer &renderer, const char *name, const CheckOptions &options)
+{
+    SoftwareBarRenderer reference;
+    BarColor color;
+    color.red = 0.2f;
+    color.green = 0.6f;
+    color.blue = 1.0f;
+    color.alpha = 0.8f;
+
+    bool matches = true;
+    std::vector<float> heights;
+    std::vector<unsigned char> pixels;
+    std::printf("%-10s %8s %12s %14s %14s\n", "renderer", "bars", "mismatches", "submit us", "frame us");
+    for (size_t numBars : {12, 48, 192, 768})
+    {
+        size_t mismatches = 0;
+        for (size_t frame = 0; frame < 8; ++frame)
+        {
+            makeHeights(numBars, frame * 11, heights);
+            renderer.render(heights, options.width, options.height, color);
+            reference.render(heights, options.width, options.height, color);
+            readPixels(options.width, options.height, pixels);
+            for (size_t i = 0; i < pixels.size(); i += 4)
+            {
+                mismatches += std::memcmp(pixels.data() + i, reference.getPixels() + i, 4) != 0;
+            }
+            if (!options.pngDirectory.empty() && frame == 0)
+            {
+                std::string path = options.pngDirectory + "/" + name + "_" + std::to_string(numBars) + ".png";
+                writePNGImage(path, pixels.data(), options.width, options.height);
+            }
+        }
+
+        // Submission is what the render thread pays, timed with the previous frame
+        // finished so that waiting for the rasterizer is not counted; the frame
+        // time includes the rasterization
+        double submitSeconds = 0.0;
+        double frameSeconds = 0.0;
+        for (size_t frame = 0; frame < options.numFrames; ++frame)
+        {
+            makeHeights(numBars, frame, heights);
+            glFinish();
+            auto start = std::chrono::steady_clock::now();
+            renderer.render(heights, options.width, options.height, color);
+            auto submitted = std::chrono::steady_clock::now();
+            glFinish();
+            submitSeconds += std::chrono::duration<double>(submitted - start).count();
+            frameSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        std::printf("%-10s %8zu %12zu %14.1f %14.1f\n", name, numBars, mismatches,
+                    submitSeconds * 1e6 / options.numFrames, frameSeconds * 1e6 / options.numFrames);
+        matches = matches && mismatches == 0;
+    }
+    return matches;
+}
+
+int main(int argc, char **argv)
+{
+    CheckOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 2;
+    }
+
+    bool matches = true;
+    {
+        HeadlessContext headless;
+        if (!headless.create(true, options.width, options.height))
+        {
+            return 3;
+        }
+        // With the loader the heights go through a persistently mapped buffer where
+        // the driver has ARB_buffer_storage, without it through an orphaned one
+        GLInstancedBarRenderer renderer;
+        if (!renderer.initialize(reinterpret_cast<GLADloadproc>(eglGetProcAddress)))
+        {
+            return 3;
+        }
+        matches = checkRenderer(renderer, renderer.isPersistentlyMapped() ? "mapped" : "instanced", options) && matches;
+    }
+    {
+        HeadlessContext headless;
+        if (!headless.create(true, options.width, options.height))
+        {
+            return 3;
+        }
+        GLInstancedBarRenderer renderer;
+        if (!renderer.initialize())
+        {
+            return 3;
+        }
+        matches = checkRenderer(renderer, "orphaned", options) && matches;
+    }
+    {
+        HeadlessContext headless;
+        if (!headless.create(false, options.width, options.height))
+        {
+            return 3;
+        }
+        GLBarRenderer renderer;
+        matches = checkRenderer(renderer, "immediate", options) && matches;
+    }
+    return matches ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+// Headless rendering: replays a WAV file through the analysis pipeline and the
+// bar display's smoothing, and writes what the window would show at every video
+// frame, without a window or GL context.
+//
+// RenderFrames [options] <file.wav>
+//   -o <dir>           output directory, default "frames"
+//   --fps <n>          video frames per second of audio, default 60
+//   --size <w>x<h>     frame size in pixels, default 1280x360
+//   --bands <n>        frequency windows, default 12
+//   --fft <n>          analysis window size, default 2048
+//   --hop <n>          hop size, default fft / 4
+//   --mode <name>      fft, constantq, slidingdft, auto
+//   --rate <hz>        resample to this rate before analysis, default the file's rate
+//   --color <r,g,b,a>  bar colour with components from 0 to 1, default 1,1,1,1
+//   --format <name>    png or raw, default png
+//
+// Frames are named frame_000000.png and so on. Raw frames are width * height
+// RGBA8 pixels, rows top to bottom, as ffmpeg reads with -f rawvideo -pix_fmt rgba.
+
+#include "BarTimeline.h"
+#include "SoftwareBarRenderer.h"
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+
+namespace fs = std::filesystem;
+
+struct RenderOptions
+{
+    fs::path outputDirectory = "frames";
+    bool writePNG = true;
+    BarVideoOptions video;
+};
+
+static void printUsage()
+{
+    std::cerr << "Usage: RenderFrames [-o dir] [--fps n] [--size wxh] [--bands n] [--fft n] [--hop n] [--mode name]\n"
+                 "                    [--rate hz] [--color r,g,b,a] [--format png|raw] <file.wav>\n";
+}
+
+static bool parseOptions(int argc, char **argv, RenderOptions &options)
+{
+    return parseBarVideoOptions(argc, argv, options.video, [&options](const std::string &argument, const char *value)
+                                {
+        if (argument == "-o")
+            options.outputDirectory = value;
+        else if (argument == "--format")
+        {
+            std::string format = value;
+            if (format != "png" && format != "raw")
+            {
+                std::cerr << "Unknown format " << format << std::endl;
+                return false;
+            }
+            options.writePNG = format == "png";
+        }
+        else
+        {
+            std::cerr << "Unknown option " << argument << std::endl;
+            return false;
+        }
+        return true; });
+}
+
+int main(int argc, char **argv)
+{
+    RenderOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 2;
+    }
+    const BarVideoOptions &video = options.video;
+
+    BarTimeline timeline(video);
+    if (!timeline.initialize())
+    {
+        std::cerr << "Failed to open " << video.input << std::endl;
+        return 1;
+    }
+
+    std::error_code error;
+    fs::create_directories(options.outputDirectory, error);
+
+    SoftwareBarRenderer renderer;
+    std::vector<float> heights;
+    const char *extension = options.writePNG ? "png" : "raw";
+    char name[64];
+
+    unsigned long long videoFrame = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (timeline.nextFrame(heights))
+    {
+        renderer.render(heights, video.width, video.height, video.color);
+
+        std::snprintf(name, sizeof(name), "frame_%06llu.%s", videoFrame, extension);
+        fs::path path = options.outputDirectory / name;
+        bool written = options.writePNG ? renderer.savePNG(path.string()) : renderer.saveRaw(path.string());
+        if (!written)
+        {
+            std::cerr << "Failed to write " << path.string() << std::endl;
+            return 1;
+        }
+        ++videoFrame;
+    }
+
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << videoFrame << " frames of " << video.width << "x" << video.height << " in " << wallSeconds << " s ("
+              << (wallSeconds > 0.0 ? videoFrame / wallSeconds : 0.0) << " frames/s)" << std::endl;
+    return 0;
+}